@@ -1,897 +1,3695 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <stdbool.h>
-#include <time.h>
-
-#define PROCESS_B 0x30000000
-
-typedef struct PageTableEntry_
-{
-    int pageNum;
-    bool dirty;
-} PageTableEntry;
-
-typedef struct PageTable_
-{
-    PageTableEntry *entries;
-    int numEntries;
-    bool isFull;
-} PageTable;
-
-typedef struct Node_
-{
-    PageTableEntry *page;
-    struct Node_ *prev;
-    struct Node_ *next;
-} Node;
-
-/**
- * Linked list used to keep track of FIFO / recency.
- * Nodes at the front of the list were added / accessed
- * most recently, while those in the back are candidates
- * for eviction.
- */
-typedef struct DLinkedList_
-{
-    int numNodes;
-    Node *header;
-    Node *trailer;
-} DLinkedList;
-
-// Page table functions.
-PageTable initPageTable();
-void printPageTable(PageTable pageTable);
-PageTableEntry *findEntry(PageTable pageTable, unsigned int pageNum);
-
-// Linked list functions.
-DLinkedList initLinkedList();
-void addFront(DLinkedList *list, PageTableEntry *page);
-void rmFront(DLinkedList *list);
-void insertFront(DLinkedList *list, Node *node);
-void addBack(DLinkedList *list, PageTableEntry *page);
-void rmBack(DLinkedList *list);
-void insertBack(DLinkedList *list, Node *node);
-Node *findNode(DLinkedList *list, PageTableEntry *page);
-void rmNode(DLinkedList *list, PageTableEntry *page);
-void updateRecency(DLinkedList *list, PageTableEntry *page);
-PageTableEntry *getLeastRecent(DLinkedList *list);
-void freeList(DLinkedList *list);
-void printList(DLinkedList *list);
-
-// Helper functions.
-unsigned int getPageNum(unsigned int address);
-unsigned int getProcess(unsigned int address);
-
-// Replacement policy functions.
-void rdm();
-void lru();
-void fifo();
-void vms();
-
-// Global variables.
-FILE *traceFile;
-int numFrames = 0, numReads = 0, 
-numWrites = 0, numEvents = 0;
-char *replacementPolicy;
-bool debug;
-
-int main(int argc, char *argv[])
-{
-    // Check for proper number of arguments.
-    if (argc != 5) {
-        printf("Usage: memsim <tracefile> <numframes> <rdm|lru|fifo|vms> "
-        "<debug|quiet>\n");
-        return -1;
-    }
-
-    // Open trace file, error check.
-    traceFile = fopen(argv[1], "r");
-    if (traceFile == NULL) {
-        printf("Failed to open %s. Ensure proper file name and file is in " 
-        "proper directory and try again.\n", argv[1]);
-        return -1;
-    }
-
-    // Read in rest of arguments.
-    sscanf(argv[2], "%d", &numFrames);
-    replacementPolicy = argv[3];
-    char *debugStr = argv[4];
-    debug = strcmp(debugStr, "debug") == 0 ? true : false;
-
-    // Execute passed replacement policy.
-    if (strcmp(replacementPolicy, "rdm") == 0) {
-        rdm();
-    }
-    else if (strcmp(replacementPolicy, "lru") == 0) {
-        lru();
-    }
-    else if (strcmp(replacementPolicy, "fifo") == 0) {
-        fifo();
-    }
-    else if (strcmp(replacementPolicy, "vms") == 0) {
-        vms();
-    }
-    else {
-        printf("Unrecognized replacement policy. Options: rdm lru fifo vms\n");
-        return -1;
-    }
-
-    // Final output.
-    printf("Total memory frames: %d\n", numFrames);
-    printf("Events in trace: %d\n", numEvents);
-    printf("Total disk reads: %d\n", numReads);
-    printf("Total disk writes: %d\n", numWrites);
-
-    return 0;
-}
-
-// Initialize empty page table of size numFrames.
-PageTable initPageTable()
-{
-    PageTable pageTable;
-    pageTable.entries = malloc(numFrames * sizeof(PageTableEntry));
-
-    int i;
-    for (i = 0; i < numFrames; i++) {
-        pageTable.entries[i].pageNum = -1;
-        pageTable.entries[i].dirty = false;
-    }
-
-    pageTable.numEntries = 0;
-    pageTable.isFull = false;
-
-    return pageTable;
-}
-
-// Print page table for debugging.
-void printPageTable(PageTable pageTable)
-{
-    printf("PAGE TABLE\n");
-    printf("numEntries: %-6d isFull: %d\n", pageTable.numEntries, pageTable.isFull);
-    printf("============================\n");
-    printf("Entry: PageNumber:    Dirty:\n");
-    int i;
-    for (i = 0; i < numFrames; i++) {
-        printf("%-6d 0x%08x     %d\n", i, pageTable.entries[i].pageNum, pageTable.entries[i].dirty);
-    }
-    printf("============================\n");
-}
-
-// Find the PTE with the passed pageNum. If not found, returns NULL.
-PageTableEntry *findEntry(PageTable pageTable, unsigned int pageNum)
-{
-    int i;
-    for (i = 0; i < numFrames; i++) {
-        if (pageTable.entries[i].pageNum == pageNum) {
-            return &pageTable.entries[i];
-        }
-    }
-
-    return NULL;
-}
-
-// Initialize an empty linked list with sentinel nodes.
-DLinkedList initLinkedList()
-{
-    DLinkedList list;
-    
-    list.header = malloc(sizeof(Node));
-    list.trailer = malloc(sizeof(Node));
-
-    list.numNodes = 0;
-
-    list.header->page = NULL;
-    list.header->next = list.trailer;
-    list.header->prev = NULL;
-
-    list.trailer->page = NULL;
-    list.trailer->prev = list.header;
-    list.trailer->next = NULL;
-
-    return list;
-}
-
-// Add the passed PTE to the front of the passed linked list.
-void addFront(DLinkedList *list, PageTableEntry *page)
-{
-    
-    Node *newNode = malloc(sizeof(Node));
-
-    newNode->page = page;
-
-    newNode->prev = list->header;
-    newNode->next = list->header->next;
-    list->header->next->prev = newNode;
-    list->header->next = newNode;
-
-    list->numNodes++;
-}
-
-// Remove the PTE at the front of the passed linked list.
-void rmFront(DLinkedList *list)
-{
-    Node *node = list->header->next;
-
-    if (node != list->trailer) {
-        
-        node->prev->next = node->next;
-        node->next->prev = node->prev;
-
-        free(node);
-
-        list->numNodes--;
-    }
-}
-
-// Insert the passed node within the passed linked list to the front of the list.
-void insertFront(DLinkedList *list, Node *node)
-{
-    Node *prev = node->prev;
-    Node *next = node->next;
-
-    prev->next = next;
-    next->prev = prev;
-    node->prev = list->header;
-    node->next = list->header->next;
-    list->header->next->prev = node;
-    list->header->next = node;
-}
-
-// Add the passed PTE to the back of the passed linked list.
-void addBack(DLinkedList *list, PageTableEntry *page)
-{
-    Node *newNode = malloc(sizeof(Node));
-
-    newNode->page = page;
-
-    newNode->next = list->trailer;
-    newNode->prev = list->trailer->prev;
-    list->trailer->prev->next = newNode;
-    list->trailer->prev = newNode;
-
-    list->numNodes++;
-}
-
-// Remove the PTE at the back of the linked list.
-void rmBack(DLinkedList *list)
-{
-    Node *node = list->trailer->prev;
-
-    if (node != list->header) {
-        node->prev->next = node->next;
-        node->next->prev = node->prev;
-
-        free(node);
-
-        list->numNodes--;
-    }
-}
-
-// Insert the passed node within the passed linked list to the back of the list.
-void insertBack(DLinkedList *list, Node *node)
-{
-    Node *prev = node->prev;
-    Node *next = node->next;
-
-    prev->next = next;
-    next->prev = prev;
-    node->next = list->trailer;
-    node->prev = list->trailer->prev;
-    list->trailer->prev->next = node;
-    list->trailer->prev = node;
-}
-
-// Find and return the node containing the passed PTE. If not found, return NULL.
-Node *findNode(DLinkedList *list, PageTableEntry *page)
-{
-    Node *currNode = list->header;
-
-    while (currNode->next != list->trailer) {
-        currNode = currNode->next;
-
-        if (currNode->page == page) {
-            
-            return currNode;
-        }
-    }
-    
-    return NULL;
-}
-
-// Remove the node with the passed PTE from the passed list.
-void rmNode(DLinkedList *list, PageTableEntry *page)
-{
-    Node *node = findNode(list, page);
-
-    if (node != NULL) {
-        node->prev->next = node->next;
-        node->next->prev = node->prev;
-
-        free(node);
-
-        list->numNodes--;
-    }
-
-}
-
-// Used for LRU. Once a page is accessed, move it to the front of the list.
-void updateRecency(DLinkedList *list, PageTableEntry *page)
-{
-    Node *node = findNode(list, page);
-
-    if (node != NULL) {
-        insertFront(list, node);
-    }
-}
-
-// Return the PTE which is next candidate for eviction. If list is empty, returns NULL.
-PageTableEntry *getLeastRecent(DLinkedList *list)
-{
-    return list->trailer->prev->page;
-}
-
-// Free all the nodes within the passed list from memory.
-void freeList(DLinkedList *list)
-{
-    while (list->numNodes != 0) {
-        rmFront(list);
-    }
-    
-    free(list->header);
-    free(list->trailer);
-    
-}
-
-// Extract the page number from the passed address.
-unsigned int getPageNum(unsigned int address)
-{
-    return address >> 12;
-}
-
-// Used for VMS. Find out which process an address corresponds to according to project description.
-// See macro PROCESS_B at start of 
-unsigned int getProcess(unsigned int address)
-{
-    return address & 0xF0000000;
-}
-
-// Print the passed list for debugging purposes.
-void printList(DLinkedList *list)
-{
-    if (list->numNodes == 0) {
-        printf("{EMPTY}");
-    }
-
-    Node *currNode = list->header;
-
-    while (currNode->next != list->trailer) {
-        currNode = currNode->next;
-        printf("0x%08x ", currNode->page->pageNum);
-    }
-    printf("\n");
-}
-
-// Random replacement policy simulation.
-void rdm()
-{
-    // Seed random function for random replacement.
-    srand(time(0));
-    PageTable pageTable = initPageTable();
-
-    // Some function variables.
-    unsigned int address, pageNum, randIndex = 0;
-    char rw, exitCh;
-    PageTableEntry *page;
-
-    // Iterate through trace file reading in address and R / W until end of file.
-    while (fscanf(traceFile, "%x %c", &address, &rw) != EOF) {
-        // Keep trace of number of events. Should be 1M at end of execution.
-        numEvents++;
-        pageNum = getPageNum(address);
-
-        // Print debug info and pause every iteration if requested.
-        if (debug) {
-            printf("NumReads: %-8d NumWrites: %-8d\n\n", numReads, numWrites);
-            printPageTable(pageTable);
-            printf("NxtPN: 0x%08x RW: %c \n", pageNum, rw);
-            printf("Enter x to exit. ");
-
-            exitCh = getchar();
-            if (exitCh == 'X' || exitCh == 'x') {
-                free(pageTable.entries);
-                exit(0);
-            }
-        }
-        
-        // Find the page within in the page table.
-        page = findEntry(pageTable, pageNum);
-
-        // If its found, update its dirty bit if its written to.
-        if (page != NULL) {
-            if (rw == 'W') {
-                page->dirty = true;
-            }
-        }
-        // Otherwise, page fault occured.
-        else {
-            // While page table is not full, fill entry by entry.
-            if (!pageTable.isFull) {
-                pageTable.entries[pageTable.numEntries].pageNum = pageNum;
-
-                if (rw == 'W') {
-                    pageTable.entries[pageTable.numEntries].dirty = true;
-                }
-
-                pageTable.numEntries++;
-                numReads++;
-
-                // Swap to replacement policy once pageTable is full.
-                if (pageTable.numEntries == numFrames) {
-                    pageTable.isFull = true;
-                }
-            }
-            // Replace pages at random.
-            else {
-                randIndex = rand() % numFrames;
-                
-                if (pageTable.entries[randIndex].dirty) {
-                    numWrites++;
-                }
-
-                pageTable.entries[randIndex].pageNum = pageNum;
-                numReads++;
-                
-                if (rw == 'R') {
-                    pageTable.entries[randIndex].dirty = false;
-                }
-                else {
-                    pageTable.entries[randIndex].dirty = true;
-                }
-            }
-        }
-    }
-
-    free(pageTable.entries);
-}
-
-// Least recenctly used replacement policy simulation.
-void lru()
-{
-    PageTable pageTable = initPageTable();
-    DLinkedList recencyList = initLinkedList();
-
-    unsigned int address, pageNum;
-    char rw, exitCh;
-
-    // Iterate through trace file reading in address and R / W until end of file.
-    PageTableEntry *page, *pageToRemove;
-    while (fscanf(traceFile, "%x %c", &address, &rw) != EOF) {
-        // Keep trace of number of events. Should be 1M at end of execution.
-        numEvents++;
-        pageNum = getPageNum(address);
-
-        // Print debug info and pause every iteration if requested.
-        if (debug) {
-            printf("NumReads: %-8d NumWrites: %-8d\n\n", numReads, numWrites);
-            printPageTable(pageTable);
-            printf("RECENCY LIST\n");
-            printList(&recencyList);
-            printf("NxtPN: 0x%08x RW: %c\n", pageNum, rw);
-            printf("Enter x to exit. ");
-
-            exitCh = getchar();
-            if (exitCh == 'X' || exitCh == 'x') {
-                free(pageTable.entries);
-                freeList(&recencyList);
-                exit(0);
-            }
-        }
-        
-        // Find the page with pageNum within the page table.
-        page = findEntry(pageTable, pageNum);
-
-        // If its found, update its recency and modify its dirty bit accordingly.
-        if (page != NULL) {
-            updateRecency(&recencyList, page);
-
-            if (rw == 'W') {
-                page->dirty = true;
-            }
-        }
-        // Otherwise, page fault occured.
-        else {
-            // While page table isnt full.
-            if (!pageTable.isFull) {
-
-                // Add page to next available entry.
-                pageTable.entries[pageTable.numEntries].pageNum = pageNum;
-
-                // Set dirty bit accordingly.
-                if (rw == 'W') {
-                    pageTable.entries[pageTable.numEntries].dirty = true;
-                }
-
-                // Update recency list to add new page to the front.
-                addFront(&recencyList, &pageTable.entries[pageTable.numEntries]);
-
-                pageTable.numEntries++;
-                numReads++;
-
-                // Swap to replacement policy once full.
-                if (pageTable.numEntries == numFrames) {
-                    pageTable.isFull = true;
-                }
-            }
-            else {
-                // Remove to page which was accessly least recently. (back of recency list)
-                pageToRemove = getLeastRecent(&recencyList);
-                
-                if (pageToRemove->dirty) {
-                    numWrites++;
-                }
-
-                // Place new page into page table, set data members accordingly.
-                pageToRemove->pageNum = pageNum;
-                numReads++;
-                if (rw == 'W') {
-                    pageToRemove->dirty = true;
-                }
-                else {
-                    pageToRemove->dirty = false;
-                }
-
-                // Update recency list to move new page to front.
-                updateRecency(&recencyList, pageToRemove);
-            }
-        }
-    }
-
-    free(pageTable.entries);
-    freeList(&recencyList);
-}
-
-// First-in-first-out replacement policy simulation.
-void fifo()
-{
-    PageTable pageTable = initPageTable();
-
-    unsigned int address, pageNum, nextPageToRemove = 0;
-    char rw, exitCh;
-
-    // Iterate through trace file reading in address and R / W until end of file.
-    PageTableEntry *page, *pageToRemove;
-    while (fscanf(traceFile, "%x %c", &address, &rw) != EOF) {
-        // Keep trace of number of events. Should be 1M at end of execution.
-        numEvents++;
-        pageNum = getPageNum(address);
-
-        // Print debug info and pause every iteration if requested.
-        if (debug) {
-            printf("NumReads: %-8d NumWrites: %-8d\n\n", numReads, numWrites);
-            printPageTable(pageTable);
-            printf("NxtPN: 0x%08x RW: %c\n", pageNum, rw);
-            printf("Enter x to exit. ");
-
-            exitCh = getchar();
-            if (exitCh == 'X' || exitCh == 'x') {
-                free(pageTable.entries);
-                exit(0);
-            }
-        }
-
-        page = findEntry(pageTable, pageNum);
-
-        // If its found, update its dirty bit if its written to.
-        if (page != NULL) {
-            if (rw == 'W') {
-                page->dirty = true;
-            }
-        }
-        // Otherwise, page fault occured.
-        else {
-            // While page table is not full, fill entry by entry.
-            if (!pageTable.isFull) {
-                pageTable.entries[pageTable.numEntries].pageNum = pageNum;
-
-                if (rw == 'W') {
-                    pageTable.entries[pageTable.numEntries].dirty = true;
-                }
-
-                pageTable.numEntries++;
-                numReads++;
-
-                // Swap to replacement policy once pageTable is full.
-                if (pageTable.numEntries == numFrames) {
-                    pageTable.isFull = true;
-                }
-            }
-            else {
-                /**
-                 * Because we placed pages from index 0 to numFrames-1, we can
-                 * simply keep track of an index variable and any time we need
-                 * to remove a page, simply increment the index variable, which
-                 * will preserve the FIFO property.
-                 */
-                if (pageTable.entries[nextPageToRemove].dirty) {
-                    numWrites++;
-                }
-
-                pageTable.entries[nextPageToRemove].pageNum = pageNum;
-                numReads++;
-                
-                if (rw == 'W') {
-                    pageTable.entries[nextPageToRemove].dirty = true;
-                }
-                else {
-                    pageTable.entries[nextPageToRemove].dirty = false;
-                }
-
-                nextPageToRemove++;
-                
-                if (nextPageToRemove == numFrames) {
-                    nextPageToRemove = 0;
-                }
-            }
-        }
-    }
-
-    free(pageTable.entries);
-}
-
-// VMS replacement policy simulation.
-void vms()
-{
-    PageTable pageTable = initPageTable();
-    DLinkedList afifo = initLinkedList();
-    DLinkedList bfifo = initLinkedList();
-    DLinkedList clean = initLinkedList();
-    DLinkedList dirty = initLinkedList();
-
-    unsigned int address, pageNum, process, rss = numFrames / 2;
-    char rw, exitCh;
-    bool isProcessA;
-
-    PageTableEntry *page, *pageToRemove;
-    while (fscanf(traceFile, "%x %c", &address, &rw) != EOF) {
-        numEvents++;
-        pageNum = getPageNum(address);
-        process = getProcess(address);
-
-        // Check which process the current page belongs to.
-        isProcessA = process != PROCESS_B ? true : false;
-
-        // Print debug info and pause every iteration if requested.
-        if (debug) {
-            printf("NumReads: %-8d NumWrites: %-8d\n\n", numReads, numWrites);
-            printPageTable(pageTable);
-            printf("A FIFO\n");
-            printList(&afifo);
-            printf("B FIFO\n");
-            printList(&bfifo);
-            printf("CLEAN LIST\n");
-            printList(&clean);
-            printf("DIRTY LIST\n");
-            printList(&dirty);
-            printf("NxtPN: 0x%08x RW: %c\n", pageNum, rw);
-            printf("Enter x to exit. ");
-
-            exitCh = getchar();
-            if (exitCh == 'X' || exitCh == 'x') {
-                free(pageTable.entries);
-                freeList(&afifo);
-                freeList(&bfifo);
-                freeList(&clean);
-                freeList(&dirty);
-                exit(0);
-            }
-        }
-        
-        // Find the page with pageNum within the page table.
-        page = findEntry(pageTable, pageNum);
-
-        Node *node;
-        // If the page is found, page hit.
-        if (page != NULL) {
-            // Remove the page from clean or dirty if its there.
-            node = findNode(&dirty, page);
-            if (node != NULL) {
-                rmNode(&dirty, page);
-            }
-
-            node = findNode(&clean, page);
-            if (node != NULL) {
-                rmNode(&clean, page);
-            }
-
-            // For process A.
-            if (isProcessA) {
-                // Find the page in its FIFO list
-                node = findNode(&afifo, page);
-
-                // If found, update its dirty bit if required.
-                if (node != NULL) {
-                    if (rw == 'W') {
-                        node->page->dirty = true;
-                    }
-                }
-                // If not found, then needs to be added to process A FIFO list.
-                else {
-                    addFront(&afifo, page);
-
-                    // If adding the page makes it exceed its RSS, remove first-in page, and add it to dirty or clean.
-                    if (afifo.numNodes >= rss) {
-                        pageToRemove = getLeastRecent(&afifo);
-                        rmNode(&afifo, pageToRemove);
-
-                        if (pageToRemove->dirty) {
-                            addFront(&dirty, pageToRemove);
-                        }
-                        else {
-                            addFront(&clean, pageToRemove);
-                        }
-
-                    }
-                }
-            }
-            // Similar to above for process B.
-            else {
-                node = findNode(&bfifo, page);
-
-                if (node != NULL) {
-                    if (rw == 'W') {
-                        node->page->dirty = true;
-                    }
-                }
-                else {
-                    addFront(&bfifo, page);
-
-                    if (bfifo.numNodes >= rss) {
-                        pageToRemove = getLeastRecent(&bfifo);
-                        rmNode(&bfifo, pageToRemove);
-
-                        if (pageToRemove->dirty) {
-                            addFront(&dirty, pageToRemove);
-                        }
-                        else {
-                            addFront(&clean, pageToRemove);
-                        }
-
-                    }
-                }
-            }
-        }
-        // Otherwise, page fault.
-        else {
-            if (!pageTable.isFull) {
-                // While page table is not full, add page to next available entry.
-                pageTable.entries[pageTable.numEntries].pageNum = pageNum;
-
-                if (rw == 'W') {
-                    pageTable.entries[pageTable.numEntries].dirty = true;
-                }
-
-                // If adding the page exceeds a process' RSS, remove first-in page, and add it to dirty or clean.
-                if (isProcessA) {
-                    addFront(&afifo, &pageTable.entries[pageTable.numEntries]);
-
-                    if (afifo.numNodes > rss) {
-                        pageToRemove = getLeastRecent(&afifo);
-                        rmNode(&afifo, pageToRemove);
-
-                        if (pageToRemove->dirty) {
-                            addFront(&dirty, pageToRemove);
-                        }
-                        else {
-                            addFront(&clean, pageToRemove);
-                        }
-                    }
-                }
-                else {
-                    addFront(&bfifo, &pageTable.entries[pageTable.numEntries]);
-
-                    if (bfifo.numNodes > rss) {
-                        pageToRemove = getLeastRecent(&bfifo);
-                        rmNode(&bfifo, pageToRemove);
-
-                        if (pageToRemove->dirty) {
-                            addFront(&dirty, pageToRemove);
-                        }
-                        else {
-                            addFront(&clean, pageToRemove);
-                        }
-                    }
-                }
-
-                pageTable.numEntries++;
-                numReads++;
-
-                // Swap to page replacement once page table is full.
-                if (pageTable.numEntries == numFrames) {
-                    pageTable.isFull = true;
-                }
-            }
-            else {
-                if (isProcessA) {
-                    // First remove from clean if able.
-                    if (clean.numNodes > 0) {
-                        pageToRemove = getLeastRecent(&clean);
-                        rmNode(&clean, pageToRemove);
-                    } 
-                    // Otherwise, remove from dirty.
-                    else if (dirty.numNodes > 0) {
-                        pageToRemove = getLeastRecent(&dirty);
-                        rmNode(&dirty, pageToRemove); 
-                    }
-                    // Otherwise, remove their own page.
-                    else {
-                        pageToRemove = getLeastRecent(&afifo);
-                        rmNode(&afifo, pageToRemove);
-                    }
-
-                    addFront(&afifo, pageToRemove);
-
-                    if (afifo.numNodes > rss) {
-                        page = getLeastRecent(&afifo);
-                        rmBack(&afifo);
-
-                        if (page->dirty) {
-                            addFront(&dirty, page);
-                        }
-                        else {
-                            addFront(&clean, page);
-                        }
-                    }
-                }
-                // Similar to above for process B.
-                else {
-                    if (clean.numNodes > 0) {
-                        pageToRemove = getLeastRecent(&clean);
-                        rmNode(&clean, pageToRemove);
-                    }
-                    else if (dirty.numNodes > 0) {
-                        pageToRemove = getLeastRecent(&dirty);
-                        rmNode(&dirty, pageToRemove);
-                    }
-                    else {
-                        pageToRemove = getLeastRecent(&bfifo);
-                        rmNode(&bfifo, pageToRemove);
-                    }
-
-                    addFront(&bfifo, pageToRemove);
-
-                    if (bfifo.numNodes > rss) {
-                        page = getLeastRecent(&bfifo);
-                        rmBack(&bfifo);
-
-                        if (page->dirty) {
-                            addFront(&dirty, page);
-                        }
-                        else {
-                            addFront(&clean, page);
-                        }
-                    }
-                }
-
-                if (pageToRemove->dirty) {
-                    numWrites++;
-                }
-
-                pageToRemove->pageNum = pageNum;
-                numReads++;
-                if (rw == 'W') {
-                    pageToRemove->dirty = true;
-                }
-                else {
-                    pageToRemove->dirty = false;
-                }
-            }
-        }
-    }
-
-    free(pageTable.entries);
-    freeList(&afifo);
-    freeList(&bfifo);
-    freeList(&clean);
-    freeList(&dirty);
-}
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+#define PROCESS_B 0x30000000
+
+// When several traces are merged, page numbers are tagged with the trace index above this bit.
+#define TRACE_SHIFT 20
+#define MAX_TRACES ((1 << (32 - TRACE_SHIFT)) - 1)
+
+// Orders in which records of multiple traces can be interleaved.
+#define MERGE_RR 0
+#define MERGE_WEIGHTED 1
+#define MERGE_TIME 2
+
+#define LINE_LEN 256
+
+// Marks a free frame in the page table and an empty slot in its index / a missing frame.
+#define EMPTY_PAGE 0xFFFFFFFF
+#define NO_FRAME 0xFFFFFFFF
+
+// Arrays at least this large are mmap'd on their own so they can be backed by huge pages.
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+// Kinds of list a frame can be on. Used by VMS to find a page's list in O(1).
+#define LIST_NONE 0
+#define LIST_FIFO 1
+#define LIST_CLEAN 2
+#define LIST_DIRTY 3
+#define LIST_RECENCY 4
+
+// Prefetchers that can run alongside any policy.
+#define PREFETCH_NONE 0
+#define PREFETCH_SEQ 1
+#define PREFETCH_STRIDE 2
+#define PREFETCH_BOTH (PREFETCH_SEQ | PREFETCH_STRIDE)
+
+// Read-ahead window a sequential stream starts with, in pages.
+#define RA_INIT_WINDOW 4
+
+// Space-Saving counters kept per process, at least HOT_MIN_COUNTERS and
+// HOT_COUNTERS_PER_PAGE per reported page. More counters tighten the count error.
+#define HOT_COUNTERS_PER_PAGE 4
+#define HOT_MIN_COUNTERS 1024
+
+// Reuse distances are histogrammed in power of two buckets: 0, 1, 2-3, 4-7, ...
+#define REUSE_BUCKETS 33
+
+// Smallest Fenwick tree the analyze mode compacts its timeline into.
+#define MIN_TIMELINE 65536
+
+// Snapshots start with this magic. The version changes whenever the layout does.
+#define CHECKPOINT_MAGIC "MEMSIMCK"
+#define CHECKPOINT_VERSION 7
+
+// Reduced traces start with this magic and are followed by ReducedRecords.
+#define REDUCED_MAGIC "MEMSIMRT"
+
+// Dense trace caches start with this magic. The version changes whenever the layout does.
+#define DENSE_MAGIC "MEMSIMDN"
+#define DENSE_VERSION 3
+
+// A dense record is its page ID, its repeats and a flags byte, followed by its timestamp
+// unless the cache has implicit timestamps, which are the record's index in the trace.
+#define DENSE_RECORD_SIZE 9
+#define DENSE_TIMESTAMP_SIZE 8
+#define DENSE_WRITE 1
+#define DENSE_REPEAT_WRITE 2
+#define DENSE_IMPLICIT_TIMESTAMPS 1
+
+// The write back daemon looks at most this many times its batch size of pages per wake up.
+#define WB_SCAN_FACTOR 4
+
+/**
+ * Page table stored as flat per frame arrays. Frames are addressed by
+ * 32-bit index, the dirty bits are packed 64 to a word, and an open
+ * addressing index maps page numbers to frames so lookups don't scan
+ * every frame. The index holds frame numbers only, the page numbers
+ * themselves are read back from pageNums. prefetchBits marks frames
+ * filled by a prefetch and not referenced since, when prefetching.
+ */
+typedef struct PageTable_
+{
+    uint32_t *pageNums;
+    uint32_t *pageIds;
+    uint64_t *dirtyBits;
+    uint64_t *prefetchBits;
+    uint32_t *index;
+    uint32_t indexSize;
+    uint32_t numFrames;
+    uint32_t numEntries;
+    uint32_t numDirty;
+    bool isFull;
+} PageTable;
+
+/**
+ * Links shared by every list of a partition. A frame is on at most one
+ * list at a time, so all lists thread through the same prev / next
+ * arrays. Slots past the last frame are the lists' sentinel nodes.
+ * listOf records the kind of list each frame is on, when needed.
+ */
+typedef struct ListLinks_
+{
+    uint32_t *prev;
+    uint32_t *next;
+    uint8_t *listOf;
+    uint32_t numSlots;
+} ListLinks;
+
+/**
+ * Linked list used to keep track of FIFO / recency.
+ * Nodes at the front of the list were added / accessed
+ * most recently, while those in the back are candidates
+ * for eviction. Nodes are frame indices into the shared links.
+ */
+typedef struct DLinkedList_
+{
+    uint32_t numNodes;
+    uint32_t header;
+    uint32_t trailer;
+    uint8_t kind;
+    ListLinks *links;
+} DLinkedList;
+
+/**
+ * A single memory reference taken from the merged trace stream.
+ * When several traces are merged, pageNum carries the trace index
+ * above TRACE_SHIFT so that pages of different traces never alias.
+ * Prefetches are issued to the policies as events with prefetch set.
+ */
+typedef struct Event_
+{
+    unsigned int address;
+    unsigned int pageNum;
+    unsigned long long timestamp;
+    char rw;
+    bool prefetch;
+    int trace;
+    int process;
+    unsigned int repeats;
+    char repeatRW;
+    uint32_t pageId;
+} Event;
+
+/**
+ * Record of a reduced trace. A run of back to back references to the same page
+ * is stored as its first reference and the number of references that followed
+ * it, with repeatRW W if any of those wrote the page.
+ */
+typedef struct ReducedRecord_
+{
+    uint32_t address;
+    uint32_t repeats;
+    char rw;
+    char repeatRW;
+} ReducedRecord;
+
+/**
+ * A dense trace cache is a DenseHeader, numRecords dense records and the
+ * page number of each of the numPages IDs of the trace, in that order.
+ * The size and modification time of the trace it was built from tell
+ * when the cache is stale.
+ */
+typedef struct DenseHeader_
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint32_t numPages;
+    uint64_t numRecords;
+    uint64_t traceSize;
+    int64_t traceModifiedSec, traceModifiedNsec;
+} DenseHeader;
+
+/**
+ * Streaming reader for one trace file. Only the next record is
+ * buffered, so merging k traces never holds more than k events.
+ */
+typedef struct TraceReader_
+{
+    char *fileName;
+    FILE *file;
+    uint64_t fileSize;
+    int64_t modifiedSec, modifiedNsec;
+    bool reduced;
+    unsigned int repeatsLeft;
+    bool dense;
+    bool denseTimestamps;
+    uint32_t idBase;
+    unsigned long long recordsLeft;
+    Event next;
+    bool hasNext;
+    unsigned long long numRecords;
+    unsigned long long numLines;
+    int weight;
+    unsigned long long numEvents;
+    unsigned long long numReads;
+    unsigned long long numWrites;
+} TraceReader;
+
+/**
+ * Open addressing hash map from page numbers to 32-bit values, grown
+ * by doubling once it is 3/4 full. Empty slots hold EMPTY_PAGE as key.
+ */
+typedef struct PageMap_
+{
+    uint32_t *keys;
+    uint32_t *values;
+    uint32_t size;
+    uint32_t count;
+    int shift;
+} PageMap;
+
+/**
+ * Space-Saving summary of the heaviest pages of a stream. Memory is fixed
+ * at capacity counters no matter how long the stream is. When a new page
+ * arrives and every counter is taken, it replaces the smallest counter and
+ * inherits its count as the error bound. Counters form a min-heap so the
+ * smallest is found in O(1), and slots maps pages to their heap position.
+ */
+typedef struct HotPages_
+{
+    uint32_t *pages;
+    unsigned long long *counts;
+    unsigned long long *errors;
+    uint32_t size;
+    uint32_t capacity;
+    PageMap slots;
+} HotPages;
+
+/**
+ * One Denning working set window of the analyze mode. The ring buffer holds
+ * the last size references and counts maps each page to its number of
+ * references inside the window, so W(t, size) is the map's entry count.
+ */
+typedef struct WorkingSet_
+{
+    uint32_t *ring;
+    uint32_t size;
+    uint32_t head;
+    PageMap counts;
+    unsigned long long sum;
+    uint32_t max;
+} WorkingSet;
+
+/**
+ * Fixed part of a checkpoint. The configuration fields must match the
+ * resuming run, except that prefetch bits and hot page summaries may be
+ * missing from the snapshot or unused by the run, so one warmed up state
+ * can be resumed with and without them. The rest of the snapshot is the
+ * raw simulation state, in the order transferState() walks it.
+ */
+typedef struct CheckpointHeader_
+{
+    char magic[8];
+    uint32_t version;
+    char policy[8];
+    int32_t numFrames;
+    int32_t numTraces;
+    int32_t mergeOrder;
+    int32_t localReplacement;
+    int32_t hasPrefetchBits;
+    int32_t denseMode;
+    uint32_t hotCounters;
+    uint64_t numEvents;
+} CheckpointHeader;
+
+// A resident page as checkpoints list them, from which any policy and frame count can be rebuilt.
+typedef struct ResidentPage_
+{
+    uint32_t pageNum;
+    uint32_t pageId;
+    uint8_t dirty;
+    uint8_t prefetched;
+} ResidentPage;
+
+/**
+ * Per process prefetch detector state. Both detectors are trained on
+ * demand misses and on first references to prefetched pages, which is
+ * what a real prefetcher would see. Pages are untagged page numbers.
+ */
+typedef struct Prefetcher_
+{
+    // Sequential read-ahead.
+    uint32_t lastPage;
+    uint32_t window;
+    uint32_t raEnd;
+
+    // Stride detection.
+    uint32_t lastMiss;
+    int64_t stride;
+    int confidence;
+} Prefetcher;
+
+/**
+ * The frames managed by one instance of the replacement policy.
+ * Global replacement uses a single partition holding every frame,
+ * local replacement gives each process a partition of its own.
+ */
+typedef struct Partition_
+{
+    PageTable pageTable;
+    ListLinks links;
+    int numProcesses;
+
+    // LRU.
+    DLinkedList recencyList;
+
+    // FIFO.
+    uint32_t nextPageToRemove;
+
+    // VMS.
+    DLinkedList *fifos;
+    DLinkedList clean;
+    DLinkedList dirty;
+    uint32_t rss;
+} Partition;
+
+// Page table functions.
+PageTable initPageTable(uint32_t numFrames);
+void printPageTable(PageTable pageTable);
+uint32_t findEntry(PageTable *pageTable, Event *event);
+uint32_t getIndexSlot(PageTable *pageTable, uint32_t pageNum);
+void setPage(PageTable *pageTable, uint32_t frame, Event *event);
+void indexInsert(PageTable *pageTable, uint32_t frame);
+bool isDirty(PageTable *pageTable, uint32_t frame);
+void setDirty(PageTable *pageTable, uint32_t frame, bool dirty);
+bool getBit(uint64_t *bits, uint32_t i);
+void setBit(uint64_t *bits, uint32_t i, bool value);
+void freePageTable(PageTable *pageTable);
+
+// Linked list functions.
+ListLinks initLinks(uint32_t numFrames, int numLists, bool trackLists);
+DLinkedList initLinkedList(ListLinks *links, int listNum, uint8_t kind);
+void linkNode(DLinkedList *list, uint32_t node, uint32_t prev, uint32_t next);
+void unlinkNode(DLinkedList *list, uint32_t node);
+void addFront(DLinkedList *list, uint32_t frame);
+void rmFront(DLinkedList *list);
+void insertFront(DLinkedList *list, uint32_t node);
+void addBack(DLinkedList *list, uint32_t frame);
+void rmBack(DLinkedList *list);
+void insertBack(DLinkedList *list, uint32_t node);
+uint32_t findNode(DLinkedList *list, uint32_t frame);
+void rmNode(DLinkedList *list, uint32_t frame);
+void updateRecency(DLinkedList *list, uint32_t frame);
+uint32_t getLeastRecent(DLinkedList *list);
+void freeLinks(ListLinks *links);
+void printList(DLinkedList *list, PageTable *pageTable);
+
+// Trace functions.
+bool openTraces(char *traceList);
+bool readRecord(TraceReader *reader);
+bool readTextRecord(TraceReader *reader);
+bool readReducedRecord(TraceReader *reader);
+bool reduceTrace(char *outName);
+bool readDenseRecord(TraceReader *reader);
+
+// Dense page ID functions.
+bool openDense(TraceReader *reader);
+bool readDenseHeader(TraceReader *reader, FILE *file, DenseHeader *header);
+bool buildDense(TraceReader *reader, char *denseName);
+bool addDenseTimestamps(FILE *out, uint64_t numRecords);
+uint32_t getDenseId(uint32_t pageNum);
+void growDensePages(uint32_t size);
+bool nextEvent(Event *event);
+void siftDown(int i);
+void freeTraces();
+
+// Partition functions.
+bool initPartitions();
+Partition *getPartition(Event *event);
+void simulateEvent(Partition *part, Event *event);
+void debugPause(Partition *part, Event *event);
+void freePartitions();
+
+// Helper functions.
+void *allocArray(size_t bytes);
+void freeArray(void *array, size_t bytes);
+unsigned int getPageNum(unsigned int address);
+unsigned int getProcess(unsigned int address);
+int getTrace(unsigned int pageNum);
+int getOwner(unsigned int pageNum);
+void diskRead(PageTable *pageTable, uint32_t frame, Event *event);
+void diskWrite(unsigned int pageNum, Event *event);
+bool parseOptions(int argc, char *argv[]);
+bool parseWeights(char *weightList);
+
+// Page map functions.
+PageMap initPageMap(uint32_t capacity);
+uint32_t getMapSlot(PageMap *map, uint32_t key);
+uint32_t *mapFind(PageMap *map, uint32_t key);
+void mapPut(PageMap *map, uint32_t key, uint32_t value);
+void mapRemove(PageMap *map, uint32_t key);
+void freePageMap(PageMap *map);
+
+// Hot page functions.
+HotPages initHotPages(uint32_t capacity);
+void countHotPage(HotPages *hot, uint32_t pageNum);
+void swapHotPages(HotPages *hot, uint32_t i, uint32_t j);
+void siftDownHotPages(HotPages *hot, uint32_t i);
+void siftUpHotPages(HotPages *hot, uint32_t i);
+void printHotPages(HotPages *hot);
+void reportHotPages();
+void freeHotPages(HotPages *hot);
+
+// Checkpoint functions.
+bool saveCheckpoint(char *fileName);
+bool loadCheckpoint(char *fileName);
+bool transferState(CheckpointHeader *header);
+bool transferResident(Partition *part, bool exact);
+uint32_t getEvictionOrder(Partition *part, uint32_t *order);
+void restorePage(Partition *part, ResidentPage *page);
+bool transfer(void *data, size_t bytes);
+bool transferOptional(void *data, size_t bytes, bool inSnapshot);
+void seedRandom(uint64_t seed);
+uint32_t nextRandom();
+
+// Analysis functions.
+void analyze();
+bool parseWindows(char *windowList);
+void freeWindows();
+uint32_t compactTimeline(uint32_t **tree, uint32_t **pageAt, uint32_t *timelineSize, PageMap *lastAccess);
+void fenwickAdd(uint32_t *tree, uint32_t size, uint32_t i, int delta);
+uint32_t fenwickSum(uint32_t *tree, uint32_t i);
+
+// Write back and cost model functions.
+void cleanPages(Partition *part);
+void writeBack(Partition *part, uint32_t frame);
+double submitIO(double latency, uint32_t pageNum, uint32_t *lastPage, bool discounted);
+void stallUntil(double finish);
+
+// Prefetch functions.
+void prefetch(Partition *part, Event *event);
+void prefetchPage(Partition *part, Event *event, int64_t delta);
+
+// Replacement policy functions.
+void rdm(Partition *part, Event *event, uint32_t frame);
+void lru(Partition *part, Event *event, uint32_t frame);
+void fifo(Partition *part, Event *event, uint32_t frame);
+void vms(Partition *part, Event *event, uint32_t frame);
+void vmsDemote(Partition *part, DLinkedList *fifo);
+
+// Global variables.
+TraceReader *traces;
+int numTraces = 0;
+int numFrames = 0;
+unsigned long long numReads = 0, numWrites = 0, numEvents = 0;
+char *replacementPolicy;
+void (*policy)(Partition *, Event *, uint32_t);
+bool debug;
+bool perfReport = false;
+
+// Merge and partitioning state.
+int mergeOrder = MERGE_RR;
+char *weightList = NULL;
+bool localReplacement = false;
+int numProcesses = 0;
+Partition *partitions;
+int numPartitions = 0;
+int *mergeHeap;
+int heapSize = 0;
+int currTrace = 0, burstLeft = 0;
+
+// Prefetch state.
+int prefetchMode = PREFETCH_NONE;
+uint32_t raMaxWindow = 32;
+int strideDepth = 4;
+Prefetcher *prefetchers;
+unsigned long long prefetchReads = 0, usefulPrefetches = 0;
+
+// Write back daemon state. It wakes up when fewer than wbLowMark frames of a partition are clean.
+uint32_t wbLowMark = 0, wbBatch = 32;
+unsigned long long backgroundWrites = 0;
+bool wbBatchStarted = false;
+
+// Cost model state, in microseconds. The device serves up to ioDepth requests at once.
+bool costModel = false;
+double hitLatency = 0.1, readLatency = 100, writeLatency = 300, ioDiscount = 0.25;
+int ioDepth = 1;
+double *channelFree;
+double simTime = 0, stallTime = 0;
+uint32_t lastReadPage = EMPTY_PAGE, lastWritePage = EMPTY_PAGE;
+
+// Checkpoint state. Saving writes to checkpointOut, loading reads from the mapped snapshot.
+char *checkpointFile = NULL, *resumeFile = NULL;
+unsigned long long checkpointInterval = 0;
+FILE *checkpointOut = NULL;
+char *checkpointCursor, *checkpointEnd;
+uint64_t rngState;
+
+/**
+ * Dense page ID state. Each trace's pages get consecutive IDs, starting after the
+ * IDs of the traces before it. densePages maps IDs back to page numbers, frameOf
+ * maps them to the frame holding them within the partition of their owner.
+ * Prefetched pages that never appear in a trace get IDs past numTracePages
+ * through denseIds, which is only kept while prefetching.
+ */
+bool denseMode = false;
+uint32_t *densePages = NULL, *frameOf = NULL;
+uint32_t numDensePages = 0, numTracePages = 0, denseCapacity = 0;
+PageMap denseIds;
+
+// Reduce mode state.
+bool reduceMode = false;
+char *reducedFile = NULL;
+
+// Analyze mode state.
+bool analyzeMode = false;
+char defaultWindows[] = "1000,10000,100000";
+char *windowList = defaultWindows;
+WorkingSet *windows;
+int numWindows = 0;
+unsigned long long sampleInterval = 0;
+
+// Hot page report state, one fault and one write back summary per process.
+uint32_t hotTopK = 0, hotCounters = 0;
+unsigned long long hotInterval = 0, hotIntervalStart = 1;
+HotPages *hotFaults;
+HotPages *hotWrites;
+
+int main(int argc, char *argv[])
+{
+    // Check for proper number of arguments.
+    if (argc < 5) {
+        printf("Usage: memsim <tracefile>[,<tracefile>...] <numframes> <rdm|lru|fifo|vms|analyze|reduce> "
+        "<debug|quiet> [-merge rr|weighted|time] [-weights w1,w2,...] [-global|-local] "
+        "[-prefetch seq|stride|both] [-ramax pages] [-stridedepth pages] "
+        "[-hot k] [-hotinterval events] [-windows w1,w2,...] [-sample events] "
+        "[-seed n] [-checkpoint file] [-checkpointevery events] [-resume file] "
+        "[-wb lowmark] [-wbbatch pages] [-cost] [-hitlat us] [-rlat us] [-wlat us] "
+        "[-iodisc factor] [-qdepth n] [-o file] [-dense] [-perf]\n");
+        return -1;
+    }
+
+    // Read in rest of arguments.
+    sscanf(argv[2], "%d", &numFrames);
+    replacementPolicy = argv[3];
+    char *debugStr = argv[4];
+    debug = strcmp(debugStr, "debug") == 0 ? true : false;
+
+    // The analyze mode characterizes the trace without simulating any frames.
+    analyzeMode = strcmp(replacementPolicy, "analyze") == 0;
+
+    // The reduce mode writes the trace out with runs of references to the same page collapsed.
+    reduceMode = strcmp(replacementPolicy, "reduce") == 0;
+
+    if (numFrames <= 0 && !analyzeMode && !reduceMode) {
+        printf("Number of frames must be positive.\n");
+        return -1;
+    }
+
+    // Select passed replacement policy.
+    if (strcmp(replacementPolicy, "rdm") == 0) {
+        policy = rdm;
+    }
+    else if (strcmp(replacementPolicy, "lru") == 0) {
+        policy = lru;
+    }
+    else if (strcmp(replacementPolicy, "fifo") == 0) {
+        policy = fifo;
+    }
+    else if (strcmp(replacementPolicy, "vms") == 0) {
+        policy = vms;
+    }
+    else if (analyzeMode || reduceMode) {
+        policy = NULL;
+    }
+    else {
+        printf("Unrecognized replacement policy. Options: rdm lru fifo vms analyze reduce\n");
+        return -1;
+    }
+
+    // Seed random function for random replacement. -seed overrides this.
+    seedRandom(time(0));
+
+    if (!parseOptions(argc, argv)) {
+        return -1;
+    }
+
+    // Open trace files, error check.
+    if (!openTraces(argv[1])) {
+        freeTraces();
+        return -1;
+    }
+
+    if (weightList != NULL && !parseWeights(weightList)) {
+        freeTraces();
+        return -1;
+    }
+
+    if (analyzeMode) {
+        if (checkpointFile != NULL || resumeFile != NULL) {
+            printf("Checkpoints are not supported by analyze.\n");
+            freeTraces();
+            return -1;
+        }
+
+        if (!parseWindows(windowList)) {
+            freeTraces();
+            return -1;
+        }
+
+        analyze();
+        freeTraces();
+        return 0;
+    }
+
+    if (reduceMode) {
+        bool reduced = reduceTrace(reducedFile);
+        freeTraces();
+        return reduced ? 0 : -1;
+    }
+
+    if (!initPartitions()) {
+        freePartitions();
+        freeTraces();
+        return -1;
+    }
+
+    prefetchers = calloc(numProcesses, sizeof(Prefetcher));
+    channelFree = calloc(ioDepth, sizeof(double));
+
+    if (hotTopK > 0) {
+        hotCounters = hotTopK * HOT_COUNTERS_PER_PAGE;
+        if (hotCounters < HOT_MIN_COUNTERS) {
+            hotCounters = HOT_MIN_COUNTERS;
+        }
+
+        hotFaults = malloc(numProcesses * sizeof(HotPages));
+        hotWrites = malloc(numProcesses * sizeof(HotPages));
+
+        int i;
+        for (i = 0; i < numProcesses; i++) {
+            hotFaults[i] = initHotPages(hotCounters);
+            hotWrites[i] = initHotPages(hotCounters);
+        }
+    }
+
+    // Continue from a snapshot, in place of the state built above.
+    if (resumeFile != NULL && !loadCheckpoint(resumeFile)) {
+        freePartitions();
+        freeTraces();
+        return -1;
+    }
+
+    // Feed the merged trace stream to the replacement policy.
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    Event event;
+    Partition *part;
+    unsigned long long lastEvents;
+    while (nextEvent(&event)) {
+        // Keep trace of number of events. Should be 1M at end of execution.
+        // A record of a reduced trace stands for 1 + repeats events.
+        lastEvents = numEvents;
+        numEvents += 1 + event.repeats;
+        traces[event.trace].numEvents += 1 + event.repeats;
+
+        part = getPartition(&event);
+
+        // Print debug info and pause every iteration if requested.
+        if (debug) {
+            debugPause(part, &event);
+        }
+
+        simulateEvent(part, &event);
+
+        // The references after the first of a run all hit, so one hit with their merged flag replays them.
+        if (event.repeats > 0) {
+            event.rw = event.repeatRW;
+            simulateEvent(part, &event);
+
+            if (costModel) {
+                simTime += hitLatency * (event.repeats - 1);
+            }
+        }
+
+        if (hotInterval > 0 && numEvents - hotIntervalStart + 1 >= hotInterval) {
+            reportHotPages();
+        }
+
+        if (checkpointInterval > 0 && numEvents / checkpointInterval != lastEvents / checkpointInterval) {
+            saveCheckpoint(checkpointFile);
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    // Final output.
+    printf("Total memory frames: %d\n", numFrames);
+    printf("Events in trace: %llu\n", numEvents);
+    printf("Total disk reads: %llu\n", numReads);
+    printf("Total disk writes: %llu\n", numWrites);
+
+    if (wbLowMark > 0) {
+        printf("Background disk writes: %llu\n", backgroundWrites);
+    }
+
+    if (costModel) {
+        printf("Effective access time: %.3f us\n", numEvents == 0 ? 0.0 : simTime / numEvents);
+        printf("Stall time: %.3f ms (%.2f%% of run time)\n", stallTime / 1000,
+            simTime == 0 ? 0.0 : 100.0 * stallTime / simTime);
+    }
+
+    if (prefetchMode != PREFETCH_NONE) {
+        printf("Demand disk reads: %llu\n", numReads - prefetchReads);
+        printf("Prefetch disk reads: %llu\n", prefetchReads);
+        printf("Useful prefetches: %llu\n", usefulPrefetches);
+        printf("Prefetch accuracy: %.2f%%\n",
+            prefetchReads == 0 ? 0.0 : 100.0 * usefulPrefetches / prefetchReads);
+    }
+
+    // Throughput of the simulation loop and peak resident memory of the whole run.
+    if (perfReport) {
+        struct rusage usage;
+        double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+        getrusage(RUSAGE_SELF, &usage);
+        printf("Events per second: %.0f\n", seconds > 0 ? numEvents / seconds : 0.0);
+        printf("Peak memory: %ld KB\n", usage.ru_maxrss);
+    }
+
+    // Per trace breakdown when several traces shared the frames.
+    if (numTraces > 1) {
+        int i;
+        for (i = 0; i < numTraces; i++) {
+            printf("Trace %d: %s\n", i, traces[i].fileName);
+            printf("  Events in trace: %llu\n", traces[i].numEvents);
+            printf("  Total disk reads: %llu\n", traces[i].numReads);
+            printf("  Total disk writes: %llu\n", traces[i].numWrites);
+        }
+    }
+
+    if (hotTopK > 0) {
+        if (numEvents >= hotIntervalStart) {
+            reportHotPages();
+        }
+
+        int i;
+        for (i = 0; i < numProcesses; i++) {
+            freeHotPages(&hotFaults[i]);
+            freeHotPages(&hotWrites[i]);
+        }
+        free(hotFaults);
+        free(hotWrites);
+    }
+
+    free(prefetchers);
+    free(channelFree);
+    freePartitions();
+    freeTraces();
+
+    return 0;
+}
+
+// Initialize empty page table of size numFrames.
+PageTable initPageTable(uint32_t numFrames)
+{
+    PageTable pageTable;
+
+    // Keep the index at most 80% full so probe sequences stay short.
+    pageTable.indexSize = numFrames + numFrames / 4 + 1;
+
+    pageTable.pageNums = allocArray((size_t) numFrames * sizeof(uint32_t));
+    pageTable.pageIds = denseMode ? allocArray((size_t) numFrames * sizeof(uint32_t)) : NULL;
+    pageTable.dirtyBits = allocArray(((size_t) numFrames + 63) / 64 * sizeof(uint64_t));
+    pageTable.prefetchBits = prefetchMode != PREFETCH_NONE
+        ? allocArray(((size_t) numFrames + 63) / 64 * sizeof(uint64_t)) : NULL;
+
+    // Dense page IDs are looked up in frameOf, so only sparse page numbers need the index.
+    if (denseMode) {
+        pageTable.indexSize = 0;
+        pageTable.index = NULL;
+        memset(pageTable.pageIds, 0xFF, (size_t) numFrames * sizeof(uint32_t));
+    }
+    else {
+        pageTable.index = allocArray((size_t) pageTable.indexSize * sizeof(uint32_t));
+        memset(pageTable.index, 0xFF, (size_t) pageTable.indexSize * sizeof(uint32_t));
+    }
+
+    memset(pageTable.pageNums, 0xFF, (size_t) numFrames * sizeof(uint32_t));
+
+    pageTable.numFrames = numFrames;
+    pageTable.numEntries = 0;
+    pageTable.numDirty = 0;
+    pageTable.isFull = false;
+
+    return pageTable;
+}
+
+// Print page table for debugging.
+void printPageTable(PageTable pageTable)
+{
+    printf("PAGE TABLE\n");
+    printf("numEntries: %-6u isFull: %d\n", pageTable.numEntries, pageTable.isFull);
+    printf("============================\n");
+    printf("Entry: PageNumber:    Dirty:\n");
+    uint32_t i;
+    for (i = 0; i < pageTable.numFrames; i++) {
+        printf("%-6u 0x%08x     %d\n", i, pageTable.pageNums[i], isDirty(&pageTable, i));
+    }
+    printf("============================\n");
+}
+
+// Find the frame holding the page of the passed event. If not found, returns NO_FRAME.
+uint32_t findEntry(PageTable *pageTable, Event *event)
+{
+    uint32_t pageNum = event->pageNum;
+    uint32_t slot, frame;
+
+    if (pageTable->pageIds != NULL) {
+        return frameOf[event->pageId];
+    }
+
+    slot = getIndexSlot(pageTable, pageNum);
+
+    while ((frame = pageTable->index[slot]) != NO_FRAME) {
+        if (pageTable->pageNums[frame] == pageNum) {
+            return frame;
+        }
+
+        if (++slot == pageTable->indexSize) {
+            slot = 0;
+        }
+    }
+
+    return NO_FRAME;
+}
+
+// Home slot of the passed pageNum within the page table index.
+uint32_t getIndexSlot(PageTable *pageTable, uint32_t pageNum)
+{
+    uint32_t hash = pageNum * 0x9E3779B1u;
+    return ((uint64_t) hash * pageTable->indexSize) >> 32;
+}
+
+/**
+ * Place the page of the passed event into the passed frame, replacing whatever
+ * page it held, and keep the index or frameOf in step. Removal shifts later
+ * entries of the probe run back so no tombstones are needed.
+ */
+void setPage(PageTable *pageTable, uint32_t frame, Event *event)
+{
+    uint32_t *index = pageTable->index;
+    uint32_t size = pageTable->indexSize;
+    uint32_t slot, next, home;
+
+    if (pageTable->pageIds != NULL) {
+        if (pageTable->pageIds[frame] != EMPTY_PAGE) {
+            frameOf[pageTable->pageIds[frame]] = NO_FRAME;
+        }
+
+        pageTable->pageIds[frame] = event->pageId;
+        pageTable->pageNums[frame] = event->pageNum;
+        frameOf[event->pageId] = frame;
+        return;
+    }
+
+    if (pageTable->pageNums[frame] != EMPTY_PAGE) {
+        slot = getIndexSlot(pageTable, pageTable->pageNums[frame]);
+        while (index[slot] != frame) {
+            if (++slot == size) {
+                slot = 0;
+            }
+        }
+
+        next = slot;
+        while (true) {
+            if (++next == size) {
+                next = 0;
+            }
+            if (index[next] == NO_FRAME) {
+                break;
+            }
+
+            // Move the entry back if the hole lies between its home slot and where it sits.
+            home = getIndexSlot(pageTable, pageTable->pageNums[index[next]]);
+            if (slot <= next ? (home <= slot || home > next) : (home <= slot && home > next)) {
+                index[slot] = index[next];
+                slot = next;
+            }
+        }
+        index[slot] = NO_FRAME;
+    }
+
+    pageTable->pageNums[frame] = event->pageNum;
+    indexInsert(pageTable, frame);
+}
+
+// Add the page held by the passed frame to the page table index.
+void indexInsert(PageTable *pageTable, uint32_t frame)
+{
+    uint32_t slot = getIndexSlot(pageTable, pageTable->pageNums[frame]);
+
+    while (pageTable->index[slot] != NO_FRAME) {
+        if (++slot == pageTable->indexSize) {
+            slot = 0;
+        }
+    }
+    pageTable->index[slot] = frame;
+}
+
+// Return whether the page in the passed frame has been written to.
+bool isDirty(PageTable *pageTable, uint32_t frame)
+{
+    return getBit(pageTable->dirtyBits, frame);
+}
+
+// Set or clear the dirty bit of the passed frame.
+void setDirty(PageTable *pageTable, uint32_t frame, bool dirty)
+{
+    if (getBit(pageTable->dirtyBits, frame) != dirty) {
+        pageTable->numDirty += dirty ? 1 : -1;
+        setBit(pageTable->dirtyBits, frame, dirty);
+    }
+}
+
+// Return bit i of the passed bitset.
+bool getBit(uint64_t *bits, uint32_t i)
+{
+    return (bits[i >> 6] >> (i & 63)) & 1;
+}
+
+// Set or clear bit i of the passed bitset.
+void setBit(uint64_t *bits, uint32_t i, bool value)
+{
+    if (value) {
+        bits[i >> 6] |= 1ULL << (i & 63);
+    }
+    else {
+        bits[i >> 6] &= ~(1ULL << (i & 63));
+    }
+}
+
+// Free the arrays of the passed page table.
+void freePageTable(PageTable *pageTable)
+{
+    freeArray(pageTable->pageNums, (size_t) pageTable->numFrames * sizeof(uint32_t));
+    freeArray(pageTable->dirtyBits, ((size_t) pageTable->numFrames + 63) / 64 * sizeof(uint64_t));
+    if (pageTable->prefetchBits != NULL) {
+        freeArray(pageTable->prefetchBits, ((size_t) pageTable->numFrames + 63) / 64 * sizeof(uint64_t));
+    }
+    if (pageTable->pageIds != NULL) {
+        freeArray(pageTable->pageIds, (size_t) pageTable->numFrames * sizeof(uint32_t));
+    }
+    else {
+        freeArray(pageTable->index, (size_t) pageTable->indexSize * sizeof(uint32_t));
+    }
+}
+
+/**
+ * Allocate the shared links for numLists lists over numFrames frames.
+ * trackLists also records which kind of list each frame is on.
+ */
+ListLinks initLinks(uint32_t numFrames, int numLists, bool trackLists)
+{
+    ListLinks links;
+
+    links.numSlots = numFrames + 2 * numLists;
+    links.prev = allocArray((size_t) links.numSlots * sizeof(uint32_t));
+    links.next = allocArray((size_t) links.numSlots * sizeof(uint32_t));
+    links.listOf = trackLists ? allocArray(links.numSlots) : NULL;
+
+    return links;
+}
+
+// Initialize an empty linked list using sentinel slots listNum of the passed links.
+DLinkedList initLinkedList(ListLinks *links, int listNum, uint8_t kind)
+{
+    DLinkedList list;
+
+    list.links = links;
+    list.kind = kind;
+    list.numNodes = 0;
+
+    list.header = links->numSlots - 2 * listNum - 2;
+    list.trailer = list.header + 1;
+
+    links->next[list.header] = list.trailer;
+    links->prev[list.header] = NO_FRAME;
+
+    links->prev[list.trailer] = list.header;
+    links->next[list.trailer] = NO_FRAME;
+
+    return list;
+}
+
+// Splice the passed node in between prev and next.
+void linkNode(DLinkedList *list, uint32_t node, uint32_t prev, uint32_t next)
+{
+    ListLinks *links = list->links;
+
+    links->prev[node] = prev;
+    links->next[node] = next;
+    links->next[prev] = node;
+    links->prev[next] = node;
+}
+
+// Splice the passed node out of its list.
+void unlinkNode(DLinkedList *list, uint32_t node)
+{
+    ListLinks *links = list->links;
+
+    links->next[links->prev[node]] = links->next[node];
+    links->prev[links->next[node]] = links->prev[node];
+}
+
+// Add the passed frame to the front of the passed linked list.
+void addFront(DLinkedList *list, uint32_t frame)
+{
+    linkNode(list, frame, list->header, list->links->next[list->header]);
+
+    if (list->links->listOf != NULL) {
+        list->links->listOf[frame] = list->kind;
+    }
+
+    list->numNodes++;
+}
+
+// Remove the frame at the front of the passed linked list.
+void rmFront(DLinkedList *list)
+{
+    uint32_t node = list->links->next[list->header];
+
+    if (node != list->trailer) {
+        rmNode(list, node);
+    }
+}
+
+// Insert the passed node within the passed linked list to the front of the list.
+void insertFront(DLinkedList *list, uint32_t node)
+{
+    unlinkNode(list, node);
+    linkNode(list, node, list->header, list->links->next[list->header]);
+}
+
+// Add the passed frame to the back of the passed linked list.
+void addBack(DLinkedList *list, uint32_t frame)
+{
+    linkNode(list, frame, list->links->prev[list->trailer], list->trailer);
+
+    if (list->links->listOf != NULL) {
+        list->links->listOf[frame] = list->kind;
+    }
+
+    list->numNodes++;
+}
+
+// Remove the frame at the back of the linked list.
+void rmBack(DLinkedList *list)
+{
+    uint32_t node = list->links->prev[list->trailer];
+
+    if (node != list->header) {
+        rmNode(list, node);
+    }
+}
+
+// Insert the passed node within the passed linked list to the back of the list.
+void insertBack(DLinkedList *list, uint32_t node)
+{
+    unlinkNode(list, node);
+    linkNode(list, node, list->links->prev[list->trailer], list->trailer);
+}
+
+/**
+ * Return the passed frame if it is on a list of the passed list's kind, NO_FRAME otherwise.
+ * Needs tracked links. VMS keeps a process' pages only on that process' FIFO,
+ * so the kind is enough to tell the FIFOs apart.
+ */
+uint32_t findNode(DLinkedList *list, uint32_t frame)
+{
+    return list->links->listOf[frame] == list->kind ? frame : NO_FRAME;
+}
+
+// Remove the passed frame from the passed list. The frame must be on the list.
+void rmNode(DLinkedList *list, uint32_t frame)
+{
+    unlinkNode(list, frame);
+
+    if (list->links->listOf != NULL) {
+        list->links->listOf[frame] = LIST_NONE;
+    }
+
+    list->numNodes--;
+}
+
+// Used for LRU. Once a page is accessed, move it to the front of the list.
+void updateRecency(DLinkedList *list, uint32_t frame)
+{
+    insertFront(list, frame);
+}
+
+// Return the frame which is next candidate for eviction. If list is empty, returns NO_FRAME.
+uint32_t getLeastRecent(DLinkedList *list)
+{
+    return list->numNodes == 0 ? NO_FRAME : list->links->prev[list->trailer];
+}
+
+// Free the arrays backing every list of a partition.
+void freeLinks(ListLinks *links)
+{
+    freeArray(links->prev, (size_t) links->numSlots * sizeof(uint32_t));
+    freeArray(links->next, (size_t) links->numSlots * sizeof(uint32_t));
+    if (links->listOf != NULL) {
+        freeArray(links->listOf, links->numSlots);
+    }
+}
+
+// Print the passed list for debugging purposes.
+void printList(DLinkedList *list, PageTable *pageTable)
+{
+    if (list->numNodes == 0) {
+        printf("{EMPTY}");
+    }
+
+    uint32_t currNode = list->header;
+
+    while (list->links->next[currNode] != list->trailer) {
+        currNode = list->links->next[currNode];
+        printf("0x%08x ", pageTable->pageNums[currNode]);
+    }
+    printf("\n");
+}
+
+// Open every file in the comma separated trace list and buffer its first record.
+bool openTraces(char *traceList)
+{
+    int i;
+    char *fileName;
+
+    numTraces = 1;
+    for (i = 0; traceList[i] != '\0'; i++) {
+        if (traceList[i] == ',') {
+            numTraces++;
+        }
+    }
+
+    if (numTraces > MAX_TRACES) {
+        printf("At most %d traces can be merged.\n", MAX_TRACES);
+        numTraces = 0;
+        return false;
+    }
+
+    traces = calloc(numTraces, sizeof(TraceReader));
+    mergeHeap = malloc(numTraces * sizeof(int));
+
+    // Each trace is its own process. A single trace is split into processes A and B by address.
+    numProcesses = numTraces > 1 ? numTraces : 2;
+
+    fileName = strtok(traceList, ",");
+    for (i = 0; i < numTraces; i++) {
+        traces[i].fileName = fileName;
+        traces[i].weight = 1;
+        traces[i].file = fileName != NULL ? fopen(fileName, "rb") : NULL;
+
+        if (traces[i].file == NULL) {
+            printf("Failed to open %s. Ensure proper file name and file is in "
+            "proper directory and try again.\n", fileName != NULL ? fileName : "");
+            return false;
+        }
+
+        // Size and modification time identify the trace to checkpoints and dense caches.
+        struct stat traceStat;
+        if (fstat(fileno(traces[i].file), &traceStat) == 0) {
+            traces[i].fileSize = traceStat.st_size;
+            traces[i].modifiedSec = traceStat.st_mtim.tv_sec;
+            traces[i].modifiedNsec = traceStat.st_mtim.tv_nsec;
+        }
+
+        // Reduced traces are recognized by their magic, anything else is read as text.
+        char magic[sizeof(REDUCED_MAGIC) - 1];
+        traces[i].reduced = fread(magic, 1, sizeof(magic), traces[i].file) == sizeof(magic)
+            && memcmp(magic, REDUCED_MAGIC, sizeof(magic)) == 0;
+        if (!traces[i].reduced) {
+            rewind(traces[i].file);
+        }
+        else if (numTraces > 1) {
+            printf("Reduced trace %s cannot be merged with other traces.\n", fileName);
+            return false;
+        }
+        else if (!analyzeMode && !reduceMode && (prefetchMode != PREFETCH_NONE || wbLowMark > 0)) {
+            printf("Reduced traces cannot be simulated with -prefetch or -wb.\n");
+            return false;
+        }
+
+        if (denseMode && !openDense(&traces[i])) {
+            return false;
+        }
+
+        readRecord(&traces[i]);
+        fileName = strtok(NULL, ",");
+    }
+
+    // Build the min-heap of trace cursors used by the timestamp merge.
+    for (i = 0; i < numTraces; i++) {
+        if (traces[i].hasNext) {
+            mergeHeap[heapSize++] = i;
+        }
+    }
+    for (i = heapSize / 2 - 1; i >= 0; i--) {
+        siftDown(i);
+    }
+
+    // Start just before the first trace so the first event comes from trace 0.
+    currTrace = numTraces - 1;
+    burstLeft = 0;
+
+    // Prefetch candidates are page numbers, which need mapping to IDs.
+    if (denseMode && prefetchMode != PREFETCH_NONE) {
+        denseIds = initPageMap(numDensePages);
+        for (i = 0; (uint32_t) i < numDensePages; i++) {
+            mapPut(&denseIds, densePages[i], i);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Read the next record of the passed trace into its lookahead slot. Returns
+ * false once the trace is exhausted.
+ */
+bool readRecord(TraceReader *reader)
+{
+    Event *event = &reader->next;
+
+    // Analyze mode expands the runs of a reduced trace back into single references.
+    if (reader->repeatsLeft > 0) {
+        reader->repeatsLeft--;
+        event->rw = event->repeatRW;
+        reader->numRecords++;
+        return true;
+    }
+
+    if (reader->dense) {
+        reader->hasNext = readDenseRecord(reader);
+    }
+    else {
+        reader->hasNext = reader->reduced ? readReducedRecord(reader) : readTextRecord(reader);
+    }
+    if (!reader->hasNext) {
+        return false;
+    }
+
+    if (analyzeMode) {
+        reader->repeatsLeft = event->repeats;
+        event->repeats = 0;
+    }
+
+    event->trace = reader - traces;
+    event->pageNum = getPageNum(event->address);
+
+    if (numTraces > 1) {
+        event->pageNum |= event->trace << TRACE_SHIFT;
+        event->process = event->trace;
+    }
+    else {
+        event->process = getProcess(event->address) == PROCESS_B ? 1 : 0;
+    }
+
+    event->prefetch = false;
+
+    reader->numRecords++;
+    return true;
+}
+
+/**
+ * Parse the next "<address> <R|W> [timestamp]" line of the passed text trace.
+ * Any flag other than W is a read, and records without a timestamp use their
+ * index in the trace. Blank lines are skipped, while lines without an address
+ * and flag, or with an address wider than 32 bits, which would alias other
+ * pages, end the run with an error.
+ */
+bool readTextRecord(TraceReader *reader)
+{
+    char line[LINE_LEN];
+    char *curr, *end;
+    unsigned long long address;
+    Event *event = &reader->next;
+
+    while (fgets(line, LINE_LEN, reader->file) != NULL) {
+        reader->numLines++;
+
+        curr = line;
+        while (*curr == ' ' || *curr == '\t' || *curr == '\r' || *curr == '\n') {
+            curr++;
+        }
+        if (*curr == '\0') {
+            continue;
+        }
+
+        address = strtoull(curr, &end, 16);
+        if (address > UINT32_MAX) {
+            printf("Address %.*s on line %llu of %s does not fit in 32 bits.\n", (int) (end - curr), curr,
+                reader->numLines, reader->fileName);
+            exit(-1);
+        }
+        event->address = address;
+
+        while (end != curr && (*end == ' ' || *end == '\t')) {
+            end++;
+        }
+        if (end == curr || *end == '\0' || *end == '\r' || *end == '\n') {
+            printf("Line %llu of %s is not \"<address> <R|W> [timestamp]\".\n", reader->numLines, reader->fileName);
+            exit(-1);
+        }
+        curr = end;
+        event->rw = *curr++ == 'W' ? 'W' : 'R';
+
+        event->timestamp = strtoull(curr, &end, 10);
+        if (end == curr) {
+            event->timestamp = reader->numRecords;
+        }
+
+        event->repeats = 0;
+        event->repeatRW = 'R';
+        return true;
+    }
+
+    return false;
+}
+
+// Read the next record of the passed reduced trace.
+bool readReducedRecord(TraceReader *reader)
+{
+    ReducedRecord record;
+    Event *event = &reader->next;
+
+    if (fread(&record, sizeof(record), 1, reader->file) != 1) {
+        return false;
+    }
+
+    event->address = record.address;
+    event->rw = record.rw;
+    event->repeats = record.repeats;
+    event->repeatRW = record.repeatRW;
+    event->timestamp = reader->numRecords;
+    return true;
+}
+
+/**
+ * Write the trace to outName with every run of back to back references to the
+ * same page collapsed into one record. Once the first reference of a run is
+ * resident the rest of the run hits, and hits with the write flags merged leave
+ * rdm, lru, fifo and vms in the same state, so simulating the reduced trace gives
+ * exactly the same reads and writes as the original.
+ */
+bool reduceTrace(char *outName)
+{
+    FILE *out;
+    ReducedRecord record;
+    Event event;
+    unsigned long long numRecords = 0;
+    bool hasRecord = false;
+
+    if (numTraces > 1) {
+        printf("Only a single trace can be reduced.\n");
+        return false;
+    }
+
+    out = fopen(outName, "wb");
+    if (out == NULL) {
+        printf("Failed to create %s.\n", outName);
+        return false;
+    }
+
+    fwrite(REDUCED_MAGIC, 1, sizeof(REDUCED_MAGIC) - 1, out);
+
+    while (nextEvent(&event)) {
+        numEvents += 1 + event.repeats;
+
+        // Extend the current run, unless its repeat count would overflow.
+        if (hasRecord && getPageNum(record.address) == event.pageNum
+            && record.repeats <= UINT32_MAX - 1 - event.repeats) {
+            record.repeats += 1 + event.repeats;
+            if (event.rw == 'W' || (event.repeats > 0 && event.repeatRW == 'W')) {
+                record.repeatRW = 'W';
+            }
+            continue;
+        }
+
+        if (hasRecord) {
+            fwrite(&record, sizeof(record), 1, out);
+            numRecords++;
+        }
+
+        memset(&record, 0, sizeof(record));
+        record.address = event.address;
+        record.repeats = event.repeats;
+        record.rw = event.rw;
+        record.repeatRW = event.repeatRW;
+        hasRecord = true;
+    }
+
+    if (hasRecord) {
+        fwrite(&record, sizeof(record), 1, out);
+        numRecords++;
+    }
+
+    if (fclose(out) != 0) {
+        printf("Failed to write %s.\n", outName);
+        return false;
+    }
+
+    printf("Events in trace: %llu\n", numEvents);
+    printf("Records after reduction: %llu (%.2f%%)\n", numRecords,
+        numEvents == 0 ? 0.0 : 100.0 * numRecords / numEvents);
+    return true;
+}
+
+// Read the next record of the passed dense trace cache.
+bool readDenseRecord(TraceReader *reader)
+{
+    unsigned char record[DENSE_RECORD_SIZE + DENSE_TIMESTAMP_SIZE];
+    size_t size = DENSE_RECORD_SIZE + (reader->denseTimestamps ? DENSE_TIMESTAMP_SIZE : 0);
+    uint32_t page;
+    Event *event = &reader->next;
+
+    if (reader->recordsLeft == 0 || fread(record, size, 1, reader->file) != 1) {
+        return false;
+    }
+    reader->recordsLeft--;
+
+    memcpy(&page, record, sizeof(page));
+    memcpy(&event->repeats, record + 4, sizeof(event->repeats));
+    event->pageId = reader->idBase + page;
+    event->address = (densePages[event->pageId] & ((1u << TRACE_SHIFT) - 1)) << 12;
+    event->rw = record[8] & DENSE_WRITE ? 'W' : 'R';
+    event->repeatRW = record[8] & DENSE_REPEAT_WRITE ? 'W' : 'R';
+
+    if (reader->denseTimestamps) {
+        memcpy(&event->timestamp, record + DENSE_RECORD_SIZE, sizeof(event->timestamp));
+    }
+    else {
+        event->timestamp = reader->numRecords;
+    }
+    return true;
+}
+
+/**
+ * Stream the next event of the merged traces. Round robin and weighted orders
+ * take up to weight consecutive events from each trace in turn, timestamp order
+ * performs a k-way merge over the trace cursors. Returns false once all traces are exhausted.
+ */
+bool nextEvent(Event *event)
+{
+    TraceReader *reader;
+
+    if (mergeOrder == MERGE_TIME) {
+        if (heapSize == 0) {
+            return false;
+        }
+
+        reader = &traces[mergeHeap[0]];
+        *event = reader->next;
+
+        if (!readRecord(reader)) {
+            mergeHeap[0] = mergeHeap[--heapSize];
+        }
+        siftDown(0);
+
+        return true;
+    }
+
+    // heapSize doubles as the number of traces with records left.
+    if (heapSize == 0) {
+        return false;
+    }
+
+    while (!traces[currTrace].hasNext || burstLeft == 0) {
+        currTrace = (currTrace + 1) % numTraces;
+        burstLeft = mergeOrder == MERGE_WEIGHTED ? traces[currTrace].weight : 1;
+    }
+
+    reader = &traces[currTrace];
+    *event = reader->next;
+    burstLeft--;
+
+    if (!readRecord(reader)) {
+        heapSize--;
+    }
+
+    return true;
+}
+
+// Restore the heap property below index i of the timestamp merge heap. Ties go to the lower trace index.
+void siftDown(int i)
+{
+    int child, tmp;
+    TraceReader *a, *b;
+
+    while ((child = 2 * i + 1) < heapSize) {
+        if (child + 1 < heapSize) {
+            a = &traces[mergeHeap[child + 1]];
+            b = &traces[mergeHeap[child]];
+            if (a->next.timestamp < b->next.timestamp
+                || (a->next.timestamp == b->next.timestamp && mergeHeap[child + 1] < mergeHeap[child])) {
+                child++;
+            }
+        }
+
+        a = &traces[mergeHeap[child]];
+        b = &traces[mergeHeap[i]];
+        if (a->next.timestamp > b->next.timestamp
+            || (a->next.timestamp == b->next.timestamp && mergeHeap[child] > mergeHeap[i])) {
+            break;
+        }
+
+        tmp = mergeHeap[i];
+        mergeHeap[i] = mergeHeap[child];
+        mergeHeap[child] = tmp;
+        i = child;
+    }
+}
+
+// Close every trace file and free the readers.
+void freeTraces()
+{
+    int i;
+    for (i = 0; i < numTraces; i++) {
+        if (traces[i].file != NULL) {
+            fclose(traces[i].file);
+        }
+    }
+
+    free(traces);
+    free(mergeHeap);
+    free(densePages);
+    free(frameOf);
+
+    if (denseIds.keys != NULL) {
+        freePageMap(&denseIds);
+    }
+}
+
+/**
+ * Switch the passed reader over to the dense cache of its trace, <trace>.dense,
+ * building it first if it is missing or was built from another version of the trace. The IDs of the
+ * trace's pages follow those of the traces opened before it.
+ */
+bool openDense(TraceReader *reader)
+{
+    char *denseName = malloc(strlen(reader->fileName) + 7);
+    DenseHeader header;
+    FILE *file;
+    uint64_t recordSize;
+    uint32_t i, tag = numTraces > 1 ? (uint32_t) (reader - traces) << TRACE_SHIFT : 0;
+
+    sprintf(denseName, "%s.dense", reader->fileName);
+    file = fopen(denseName, "rb");
+    if (file == NULL || !readDenseHeader(reader, file, &header)) {
+        if (file != NULL) {
+            fclose(file);
+        }
+        if (!buildDense(reader, denseName)) {
+            free(denseName);
+            return false;
+        }
+
+        file = fopen(denseName, "rb");
+        if (file == NULL || !readDenseHeader(reader, file, &header)) {
+            printf("Failed to read %s.\n", denseName);
+            if (file != NULL) {
+                fclose(file);
+            }
+            free(denseName);
+            return false;
+        }
+    }
+
+    // The page numbers of the IDs follow the records.
+    growDensePages(numDensePages + header.numPages);
+    reader->denseTimestamps = !(header.flags & DENSE_IMPLICIT_TIMESTAMPS);
+    recordSize = DENSE_RECORD_SIZE + (reader->denseTimestamps ? DENSE_TIMESTAMP_SIZE : 0);
+    if (fseek(file, sizeof(header) + header.numRecords * recordSize, SEEK_SET) != 0
+        || fread(densePages + numDensePages, sizeof(uint32_t), header.numPages, file) != header.numPages
+        || fseek(file, sizeof(header), SEEK_SET) != 0) {
+        printf("Dense trace %s is truncated. Delete it to rebuild it.\n", denseName);
+        fclose(file);
+        free(denseName);
+        return false;
+    }
+
+    for (i = 0; i < header.numPages; i++) {
+        densePages[numDensePages + i] |= tag;
+    }
+
+    fclose(reader->file);
+    reader->file = file;
+    reader->dense = true;
+    reader->idBase = numDensePages;
+    reader->recordsLeft = header.numRecords;
+
+    numDensePages += header.numPages;
+    numTracePages = numDensePages;
+
+    free(denseName);
+    return true;
+}
+
+// Read the header of the passed dense cache, returning whether it was built by this version from the reader's trace as it is now.
+bool readDenseHeader(TraceReader *reader, FILE *file, DenseHeader *header)
+{
+    return fread(header, sizeof(*header), 1, file) == 1
+        && memcmp(header->magic, DENSE_MAGIC, sizeof(header->magic)) == 0
+        && header->version == DENSE_VERSION
+        && header->traceSize == reader->fileSize
+        && header->traceModifiedSec == reader->modifiedSec
+        && header->traceModifiedNsec == reader->modifiedNsec;
+}
+
+/**
+ * Decode the passed reader's trace into a dense cache, numbering pages in the order they first appear.
+ * Timestamps are left out as long as every record's is its index in the trace.
+ */
+bool buildDense(TraceReader *reader, char *denseName)
+{
+    char *tmpName = malloc(strlen(denseName) + 5);
+    DenseHeader header;
+    unsigned char record[DENSE_RECORD_SIZE];
+    Event *event = &reader->next;
+    PageMap ids = initPageMap(1024);
+    uint32_t *pages = NULL, *id, page, pageId, capacity = 0;
+    bool built = true;
+    FILE *out;
+
+    sprintf(tmpName, "%s.tmp", denseName);
+    out = fopen(tmpName, "w+b");
+    if (out == NULL) {
+        printf("Failed to create %s.\n", tmpName);
+        freePageMap(&ids);
+        free(tmpName);
+        return false;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, DENSE_MAGIC, sizeof(header.magic));
+    header.version = DENSE_VERSION;
+    header.flags = DENSE_IMPLICIT_TIMESTAMPS;
+    header.traceSize = reader->fileSize;
+    header.traceModifiedSec = reader->modifiedSec;
+    header.traceModifiedNsec = reader->modifiedNsec;
+    fwrite(&header, sizeof(header), 1, out);
+
+    while (reader->reduced ? readReducedRecord(reader) : readTextRecord(reader)) {
+        page = getPageNum(event->address);
+        id = mapFind(&ids, page);
+
+        if (id != NULL) {
+            pageId = *id;
+        }
+        else {
+            if (header.numPages == capacity) {
+                capacity = capacity == 0 ? 1024 : capacity * 2;
+                pages = realloc(pages, capacity * sizeof(uint32_t));
+            }
+            pages[header.numPages] = page;
+            mapPut(&ids, page, header.numPages);
+            pageId = header.numPages++;
+        }
+
+        // The first record whose timestamp is not its index makes every record carry its timestamp.
+        if ((header.flags & DENSE_IMPLICIT_TIMESTAMPS) && event->timestamp != header.numRecords) {
+            header.flags &= ~DENSE_IMPLICIT_TIMESTAMPS;
+            built = built && addDenseTimestamps(out, header.numRecords);
+        }
+
+        memcpy(record, &pageId, sizeof(pageId));
+        memcpy(record + 4, &event->repeats, sizeof(event->repeats));
+        record[8] = (event->rw == 'W' ? DENSE_WRITE : 0) | (event->repeatRW == 'W' ? DENSE_REPEAT_WRITE : 0);
+        fwrite(record, sizeof(record), 1, out);
+        if (!(header.flags & DENSE_IMPLICIT_TIMESTAMPS)) {
+            fwrite(&event->timestamp, sizeof(event->timestamp), 1, out);
+        }
+
+        header.numRecords++;
+        reader->numRecords++;
+    }
+    reader->numRecords = 0;
+
+    fwrite(pages, sizeof(uint32_t), header.numPages, out);
+    rewind(out);
+    fwrite(&header, sizeof(header), 1, out);
+    built = built && ferror(out) == 0;
+    built = fclose(out) == 0 && built && rename(tmpName, denseName) == 0;
+
+    if (!built) {
+        printf("Failed to write %s.\n", denseName);
+        remove(tmpName);
+    }
+
+    freePageMap(&ids);
+    free(pages);
+    free(tmpName);
+    return built;
+}
+
+/**
+ * Give each of the numRecords records already written to the passed dense cache
+ * its index as timestamp, leaving the cache positioned after them.
+ */
+bool addDenseTimestamps(FILE *out, uint64_t numRecords)
+{
+    FILE *records = tmpfile();
+    unsigned char record[DENSE_RECORD_SIZE];
+    uint64_t i;
+    bool copied;
+
+    if (records == NULL) {
+        return false;
+    }
+
+    fseek(out, sizeof(DenseHeader), SEEK_SET);
+    for (i = 0; i < numRecords && fread(record, sizeof(record), 1, out) == 1; i++) {
+        fwrite(record, sizeof(record), 1, records);
+    }
+    copied = i == numRecords && ferror(records) == 0;
+
+    rewind(records);
+    fseek(out, sizeof(DenseHeader), SEEK_SET);
+    for (i = 0; copied && i < numRecords && fread(record, sizeof(record), 1, records) == 1; i++) {
+        fwrite(record, sizeof(record), 1, out);
+        fwrite(&i, sizeof(i), 1, out);
+    }
+    copied = copied && i == numRecords;
+
+    fclose(records);
+    return copied;
+}
+
+// Return the ID of the passed page number, handing out a new one to pages that are in no trace.
+uint32_t getDenseId(uint32_t pageNum)
+{
+    uint32_t *id = mapFind(&denseIds, pageNum);
+
+    if (id != NULL) {
+        return *id;
+    }
+
+    growDensePages(numDensePages + 1);
+    densePages[numDensePages] = pageNum;
+    mapPut(&denseIds, pageNum, numDensePages);
+    return numDensePages++;
+}
+
+// Make room for size IDs in densePages and frameOf. New IDs are not resident.
+void growDensePages(uint32_t size)
+{
+    uint32_t i;
+
+    if (size <= denseCapacity) {
+        return;
+    }
+
+    size = size > 2 * denseCapacity ? size : 2 * denseCapacity;
+    densePages = realloc(densePages, (size_t) size * sizeof(uint32_t));
+    frameOf = realloc(frameOf, (size_t) size * sizeof(uint32_t));
+    for (i = denseCapacity; i < size; i++) {
+        frameOf[i] = NO_FRAME;
+    }
+    denseCapacity = size;
+}
+
+/**
+ * Create the policy partitions. Local replacement splits the frames between
+ * processes in proportion to the trace weights, handing the remainder out
+ * one frame at a time starting with the first process. Only the metadata
+ * the chosen policy uses is allocated.
+ */
+bool initPartitions()
+{
+    int i, j, totalWeight = 0;
+    uint32_t frames;
+
+    if (numFrames < (localReplacement ? numProcesses : 1)) {
+        printf("Local replacement needs at least one frame per process.\n");
+        return false;
+    }
+
+    numPartitions = localReplacement ? numProcesses : 1;
+
+    for (i = 0; i < numPartitions; i++) {
+        totalWeight += numTraces > 1 ? traces[i].weight : 1;
+    }
+
+    partitions = calloc(numPartitions, sizeof(Partition));
+
+    uint32_t assigned = 0;
+    for (i = 0; i < numPartitions; i++) {
+        frames = (long long) numFrames * (numTraces > 1 ? traces[i].weight : 1) / totalWeight;
+        partitions[i].pageTable.numFrames = frames;
+        assigned += frames;
+    }
+    for (i = 0; assigned < (uint32_t) numFrames; i = (i + 1) % numPartitions) {
+        partitions[i].pageTable.numFrames++;
+        assigned++;
+    }
+
+    for (i = 0; i < numPartitions; i++) {
+        Partition *part = &partitions[i];
+        frames = part->pageTable.numFrames;
+
+        if (frames == 0) {
+            printf("Local replacement needs at least one frame per process.\n");
+            return false;
+        }
+
+        part->pageTable = initPageTable(frames);
+        part->numProcesses = localReplacement ? 1 : numProcesses;
+        part->nextPageToRemove = 0;
+
+        if (policy == lru) {
+            part->links = initLinks(frames, 1, false);
+            part->recencyList = initLinkedList(&part->links, 0, LIST_RECENCY);
+        }
+        else if (policy == vms) {
+            part->links = initLinks(frames, part->numProcesses + 2, true);
+            part->clean = initLinkedList(&part->links, 0, LIST_CLEAN);
+            part->dirty = initLinkedList(&part->links, 1, LIST_DIRTY);
+
+            // VMS splits the partition's frames evenly into per process resident sets.
+            part->fifos = malloc(part->numProcesses * sizeof(DLinkedList));
+            for (j = 0; j < part->numProcesses; j++) {
+                part->fifos[j] = initLinkedList(&part->links, j + 2, LIST_FIFO);
+            }
+            part->rss = frames / part->numProcesses;
+        }
+    }
+
+    return true;
+}
+
+// Return the partition whose frames the passed event competes for.
+Partition *getPartition(Event *event)
+{
+    return localReplacement ? &partitions[event->process] : &partitions[0];
+}
+
+/**
+ * Simulate one demand reference. A first reference to a prefetched page counts
+ * as a useful prefetch and, like a miss, gives the prefetchers a chance to run.
+ */
+void simulateEvent(Partition *part, Event *event)
+{
+    PageTable *pageTable = &part->pageTable;
+    uint32_t frame = findEntry(pageTable, event);
+    bool trigger = frame == NO_FRAME;
+
+    if (costModel) {
+        simTime += hitLatency;
+    }
+
+    if (frame != NO_FRAME && pageTable->prefetchBits != NULL && getBit(pageTable->prefetchBits, frame)) {
+        setBit(pageTable->prefetchBits, frame, false);
+        usefulPrefetches++;
+        trigger = true;
+    }
+
+    policy(part, event, frame);
+
+    if (trigger && prefetchMode != PREFETCH_NONE) {
+        prefetch(part, event);
+    }
+
+    if (wbLowMark > 0 && pageTable->isFull) {
+        cleanPages(part);
+    }
+}
+
+// Print the state of the passed partition and wait for the user before simulating the event.
+void debugPause(Partition *part, Event *event)
+{
+    int i;
+    char exitCh;
+
+    printf("NumReads: %-8llu NumWrites: %-8llu\n\n", numReads, numWrites);
+    printPageTable(part->pageTable);
+
+    if (policy == lru) {
+        printf("RECENCY LIST\n");
+        printList(&part->recencyList, &part->pageTable);
+    }
+    else if (policy == vms) {
+        for (i = 0; i < part->numProcesses; i++) {
+            printf("PROCESS %d FIFO\n", i);
+            printList(&part->fifos[i], &part->pageTable);
+        }
+        printf("CLEAN LIST\n");
+        printList(&part->clean, &part->pageTable);
+        printf("DIRTY LIST\n");
+        printList(&part->dirty, &part->pageTable);
+    }
+
+    printf("NxtPN: 0x%08x RW: %c\n", event->pageNum, event->rw);
+    printf("Enter x to exit. ");
+
+    exitCh = getchar();
+    if (exitCh == 'X' || exitCh == 'x') {
+        freePartitions();
+        freeTraces();
+        exit(0);
+    }
+}
+
+// Free the page tables and lists of every partition.
+void freePartitions()
+{
+    int i;
+
+    if (partitions == NULL) {
+        return;
+    }
+
+    for (i = 0; i < numPartitions; i++) {
+        Partition *part = &partitions[i];
+
+        if (part->pageTable.pageNums == NULL) {
+            continue;
+        }
+
+        freePageTable(&part->pageTable);
+        if (part->links.prev != NULL) {
+            freeLinks(&part->links);
+        }
+        free(part->fifos);
+    }
+
+    free(partitions);
+}
+
+/**
+ * Allocate a zeroed array. Large arrays get their own mapping and are
+ * advised onto transparent huge pages, which keeps TLB misses down when
+ * tens of millions of frames are simulated. Exits if memory runs out.
+ */
+void *allocArray(size_t bytes)
+{
+    void *array;
+
+    if (bytes >= HUGE_PAGE_SIZE) {
+        array = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (array == MAP_FAILED) {
+            array = NULL;
+        }
+#ifdef MADV_HUGEPAGE
+        else {
+            madvise(array, bytes, MADV_HUGEPAGE);
+        }
+#endif
+    }
+    else {
+        array = calloc(1, bytes);
+    }
+
+    if (array == NULL) {
+        printf("Failed to allocate %zu bytes.\n", bytes);
+        exit(-1);
+    }
+
+    return array;
+}
+
+// Free an array from allocArray. The size must match the allocation.
+void freeArray(void *array, size_t bytes)
+{
+    if (bytes >= HUGE_PAGE_SIZE) {
+        munmap(array, bytes);
+    }
+    else {
+        free(array);
+    }
+}
+
+// Extract the page number from the passed address.
+unsigned int getPageNum(unsigned int address)
+{
+    return address >> 12;
+}
+
+// Used for VMS. Find out which process an address corresponds to according to project description.
+// See macro PROCESS_B at start of
+unsigned int getProcess(unsigned int address)
+{
+    return address & 0xF0000000;
+}
+
+// Find out which trace the passed (possibly tagged) page number came from.
+int getTrace(unsigned int pageNum)
+{
+    return numTraces > 1 ? pageNum >> TRACE_SHIFT : 0;
+}
+
+// Find out which process owns the passed (possibly tagged) page number.
+int getOwner(unsigned int pageNum)
+{
+    if (numTraces > 1) {
+        return pageNum >> TRACE_SHIFT;
+    }
+
+    return getProcess(pageNum << 12) == PROCESS_B ? 1 : 0;
+}
+
+// Account for reading the page of the passed event in from disk into the passed frame.
+void diskRead(PageTable *pageTable, uint32_t frame, Event *event)
+{
+    numReads++;
+    traces[event->trace].numReads++;
+
+    if (event->prefetch) {
+        prefetchReads++;
+    }
+    else if (hotTopK > 0) {
+        countHotPage(&hotFaults[event->process], event->pageNum);
+    }
+
+    if (pageTable->prefetchBits != NULL) {
+        setBit(pageTable->prefetchBits, frame, event->prefetch);
+    }
+
+    // Demand reads stall the process, prefetch reads complete in the background.
+    if (costModel) {
+        double finish = submitIO(readLatency, event->pageNum, &lastReadPage, false);
+        if (!event->prefetch) {
+            stallUntil(finish);
+        }
+    }
+}
+
+/**
+ * Account for writing the passed dirty page back to disk. The write is charged
+ * to the page's owner. event is the access that evicted it, or NULL when the
+ * write back daemon cleans it in the background.
+ */
+void diskWrite(unsigned int pageNum, Event *event)
+{
+    numWrites++;
+    traces[getTrace(pageNum)].numWrites++;
+
+    if (hotTopK > 0) {
+        countHotPage(&hotWrites[getOwner(pageNum)], pageNum);
+    }
+
+    if (event == NULL) {
+        backgroundWrites++;
+    }
+
+    // Writes evicting a page for a demand access stall it, later writes of a batch are discounted.
+    if (costModel) {
+        double finish = submitIO(writeLatency, pageNum, &lastWritePage, event == NULL && wbBatchStarted);
+        if (event != NULL && !event->prefetch) {
+            stallUntil(finish);
+        }
+    }
+    wbBatchStarted = event == NULL;
+}
+
+// Parse the optional flags following the required arguments.
+bool parseOptions(int argc, char *argv[])
+{
+    int i;
+    bool orderGiven = false;
+
+    for (i = 5; i < argc; i++) {
+        if (strcmp(argv[i], "-merge") == 0 && i + 1 < argc) {
+            i++;
+            orderGiven = true;
+
+            if (strcmp(argv[i], "rr") == 0) {
+                mergeOrder = MERGE_RR;
+            }
+            else if (strcmp(argv[i], "weighted") == 0) {
+                mergeOrder = MERGE_WEIGHTED;
+            }
+            else if (strcmp(argv[i], "time") == 0) {
+                mergeOrder = MERGE_TIME;
+            }
+            else {
+                printf("Unrecognized merge order. Options: rr weighted time\n");
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "-weights") == 0 && i + 1 < argc) {
+            weightList = argv[++i];
+        }
+        else if (strcmp(argv[i], "-local") == 0) {
+            localReplacement = true;
+        }
+        else if (strcmp(argv[i], "-global") == 0) {
+            localReplacement = false;
+        }
+        else if (strcmp(argv[i], "-prefetch") == 0 && i + 1 < argc) {
+            i++;
+
+            if (strcmp(argv[i], "seq") == 0) {
+                prefetchMode = PREFETCH_SEQ;
+            }
+            else if (strcmp(argv[i], "stride") == 0) {
+                prefetchMode = PREFETCH_STRIDE;
+            }
+            else if (strcmp(argv[i], "both") == 0) {
+                prefetchMode = PREFETCH_BOTH;
+            }
+            else {
+                printf("Unrecognized prefetcher. Options: seq stride both\n");
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "-hot") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%u", &hotTopK) != 1 || hotTopK == 0 || hotTopK > (1u << 24)) {
+                printf("Number of hot pages must be between 1 and %u.\n", 1u << 24);
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "-hotinterval") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%llu", &hotInterval) != 1 || hotInterval == 0) {
+                printf("Hot page interval must be positive.\n");
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc) {
+            unsigned long long seed;
+            if (sscanf(argv[++i], "%llu", &seed) != 1) {
+                printf("Seed must be a non-negative integer.\n");
+                return false;
+            }
+            seedRandom(seed);
+        }
+        else if (strcmp(argv[i], "-checkpoint") == 0 && i + 1 < argc) {
+            checkpointFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "-checkpointevery") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%llu", &checkpointInterval) != 1 || checkpointInterval == 0) {
+                printf("Checkpoint interval must be positive.\n");
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "-resume") == 0 && i + 1 < argc) {
+            resumeFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "-wb") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%u", &wbLowMark) != 1 || wbLowMark == 0) {
+                printf("Write back low watermark must be positive.\n");
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "-wbbatch") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%u", &wbBatch) != 1 || wbBatch == 0) {
+                printf("Write back batch must be positive.\n");
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "-cost") == 0) {
+            costModel = true;
+        }
+        else if ((strcmp(argv[i], "-hitlat") == 0 || strcmp(argv[i], "-rlat") == 0
+            || strcmp(argv[i], "-wlat") == 0) && i + 1 < argc) {
+            double *latency = argv[i][1] == 'h' ? &hitLatency : argv[i][1] == 'r' ? &readLatency : &writeLatency;
+            if (sscanf(argv[++i], "%lf", latency) != 1 || *latency < 0) {
+                printf("Latencies must be non-negative.\n");
+                return false;
+            }
+            costModel = true;
+        }
+        else if (strcmp(argv[i], "-iodisc") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%lf", &ioDiscount) != 1 || ioDiscount < 0 || ioDiscount > 1) {
+                printf("I/O discount must be between 0 and 1.\n");
+                return false;
+            }
+            costModel = true;
+        }
+        else if (strcmp(argv[i], "-qdepth") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%d", &ioDepth) != 1 || ioDepth <= 0) {
+                printf("Queue depth must be positive.\n");
+                return false;
+            }
+            costModel = true;
+        }
+        else if (strcmp(argv[i], "-perf") == 0) {
+            perfReport = true;
+        }
+        else if (strcmp(argv[i], "-dense") == 0) {
+            denseMode = true;
+        }
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            reducedFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "-windows") == 0 && i + 1 < argc) {
+            windowList = argv[++i];
+        }
+        else if (strcmp(argv[i], "-sample") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%llu", &sampleInterval) != 1 || sampleInterval == 0) {
+                printf("Sample interval must be positive.\n");
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "-ramax") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%u", &raMaxWindow) != 1 || raMaxWindow == 0) {
+                printf("Read-ahead window must be positive.\n");
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "-stridedepth") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%d", &strideDepth) != 1 || strideDepth <= 0) {
+                printf("Stride depth must be positive.\n");
+                return false;
+            }
+        }
+        else {
+            printf("Unrecognized option %s.\n", argv[i]);
+            return false;
+        }
+    }
+
+    if ((checkpointFile == NULL) != (checkpointInterval == 0)) {
+        printf("-checkpoint and -checkpointevery must be used together.\n");
+        return false;
+    }
+
+    if (reduceMode != (reducedFile != NULL)) {
+        printf("reduce needs -o and -o is only used by reduce.\n");
+        return false;
+    }
+
+    if (hotInterval > 0 && hotTopK == 0) {
+        printf("-hotinterval needs -hot.\n");
+        return false;
+    }
+
+    // Passing weights implies a weighted merge unless another order was requested.
+    if (weightList != NULL && !orderGiven) {
+        mergeOrder = MERGE_WEIGHTED;
+    }
+
+    return true;
+}
+
+// Parse the comma separated per trace weights, one positive integer per trace.
+// Round robin merging ignores them, but local replacement still splits frames by them.
+bool parseWeights(char *weightList)
+{
+    int i = 0;
+    char *weight = strtok(weightList, ",");
+
+    while (weight != NULL) {
+        if (i == numTraces || sscanf(weight, "%d", &traces[i].weight) != 1 || traces[i].weight <= 0) {
+            printf("Expected one positive weight per trace.\n");
+            return false;
+        }
+
+        i++;
+        weight = strtok(NULL, ",");
+    }
+
+    if (i != numTraces) {
+        printf("Expected one positive weight per trace.\n");
+        return false;
+    }
+
+    return true;
+}
+
+// Initialize an empty page map sized to hold capacity entries without growing.
+PageMap initPageMap(uint32_t capacity)
+{
+    PageMap map;
+
+    map.size = 16;
+    map.shift = 28;
+    while (map.size / 4 * 3 < capacity) {
+        map.size *= 2;
+        map.shift--;
+    }
+
+    map.keys = allocArray((size_t) map.size * sizeof(uint32_t));
+    map.values = allocArray((size_t) map.size * sizeof(uint32_t));
+    memset(map.keys, 0xFF, (size_t) map.size * sizeof(uint32_t));
+    map.count = 0;
+
+    return map;
+}
+
+// Home slot of the passed key. Uses the high bits of a multiplicative hash.
+uint32_t getMapSlot(PageMap *map, uint32_t key)
+{
+    return (key * 0x9E3779B1u) >> map->shift;
+}
+
+// Return a pointer to the value stored for key. If not found, returns NULL.
+uint32_t *mapFind(PageMap *map, uint32_t key)
+{
+    uint32_t slot = getMapSlot(map, key);
+
+    while (map->keys[slot] != EMPTY_PAGE) {
+        if (map->keys[slot] == key) {
+            return &map->values[slot];
+        }
+        slot = (slot + 1) & (map->size - 1);
+    }
+
+    return NULL;
+}
+
+// Store value for key, replacing any previous value.
+void mapPut(PageMap *map, uint32_t key, uint32_t value)
+{
+    uint32_t slot, i;
+
+    if (map->count + 1 > map->size / 4 * 3) {
+        PageMap grown = initPageMap(map->size);
+        for (i = 0; i < map->size; i++) {
+            if (map->keys[i] != EMPTY_PAGE) {
+                mapPut(&grown, map->keys[i], map->values[i]);
+            }
+        }
+        freePageMap(map);
+        *map = grown;
+    }
+
+    slot = getMapSlot(map, key);
+    while (map->keys[slot] != EMPTY_PAGE && map->keys[slot] != key) {
+        slot = (slot + 1) & (map->size - 1);
+    }
+
+    if (map->keys[slot] == EMPTY_PAGE) {
+        map->count++;
+    }
+    map->keys[slot] = key;
+    map->values[slot] = value;
+}
+
+// Remove key from the map, shifting later entries of its probe run back into the hole.
+void mapRemove(PageMap *map, uint32_t key)
+{
+    uint32_t mask = map->size - 1;
+    uint32_t slot = getMapSlot(map, key);
+    uint32_t next, home;
+
+    while (map->keys[slot] != key) {
+        if (map->keys[slot] == EMPTY_PAGE) {
+            return;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    for (next = (slot + 1) & mask; map->keys[next] != EMPTY_PAGE; next = (next + 1) & mask) {
+        home = getMapSlot(map, map->keys[next]);
+        if (((next - home) & mask) >= ((next - slot) & mask)) {
+            map->keys[slot] = map->keys[next];
+            map->values[slot] = map->values[next];
+            slot = next;
+        }
+    }
+
+    map->keys[slot] = EMPTY_PAGE;
+    map->count--;
+}
+
+// Free the arrays of the passed map.
+void freePageMap(PageMap *map)
+{
+    freeArray(map->keys, (size_t) map->size * sizeof(uint32_t));
+    freeArray(map->values, (size_t) map->size * sizeof(uint32_t));
+}
+
+// Initialize an empty Space-Saving summary with the passed number of counters.
+HotPages initHotPages(uint32_t capacity)
+{
+    HotPages hot;
+
+    hot.pages = malloc(capacity * sizeof(uint32_t));
+    hot.counts = malloc(capacity * sizeof(unsigned long long));
+    hot.errors = malloc(capacity * sizeof(unsigned long long));
+    hot.size = 0;
+    hot.capacity = capacity;
+    hot.slots = initPageMap(capacity);
+
+    return hot;
+}
+
+// Count one occurrence of the passed page.
+void countHotPage(HotPages *hot, uint32_t pageNum)
+{
+    uint32_t *slot = mapFind(&hot->slots, pageNum);
+
+    if (slot != NULL) {
+        hot->counts[*slot]++;
+        siftDownHotPages(hot, *slot);
+    }
+    // Start a new counter while there is room.
+    else if (hot->size < hot->capacity) {
+        hot->pages[hot->size] = pageNum;
+        hot->counts[hot->size] = 1;
+        hot->errors[hot->size] = 0;
+        mapPut(&hot->slots, pageNum, hot->size);
+        hot->size++;
+        siftUpHotPages(hot, hot->size - 1);
+    }
+    // Otherwise take over the smallest counter.
+    else {
+        mapRemove(&hot->slots, hot->pages[0]);
+        hot->pages[0] = pageNum;
+        hot->errors[0] = hot->counts[0];
+        hot->counts[0]++;
+        mapPut(&hot->slots, pageNum, 0);
+        siftDownHotPages(hot, 0);
+    }
+}
+
+// Swap two counters of the heap, keeping the slot map in step.
+void swapHotPages(HotPages *hot, uint32_t i, uint32_t j)
+{
+    uint32_t page = hot->pages[i];
+    unsigned long long count = hot->counts[i], error = hot->errors[i];
+
+    hot->pages[i] = hot->pages[j];
+    hot->counts[i] = hot->counts[j];
+    hot->errors[i] = hot->errors[j];
+    hot->pages[j] = page;
+    hot->counts[j] = count;
+    hot->errors[j] = error;
+
+    *mapFind(&hot->slots, hot->pages[i]) = i;
+    *mapFind(&hot->slots, hot->pages[j]) = j;
+}
+
+// Move counter i down the min-heap until its children are no smaller.
+void siftDownHotPages(HotPages *hot, uint32_t i)
+{
+    uint32_t child;
+
+    while ((child = 2 * i + 1) < hot->size) {
+        if (child + 1 < hot->size && hot->counts[child + 1] < hot->counts[child]) {
+            child++;
+        }
+        if (hot->counts[child] >= hot->counts[i]) {
+            break;
+        }
+
+        swapHotPages(hot, i, child);
+        i = child;
+    }
+}
+
+// Move counter i up the min-heap until its parent is no larger.
+void siftUpHotPages(HotPages *hot, uint32_t i)
+{
+    while (i > 0 && hot->counts[(i - 1) / 2] > hot->counts[i]) {
+        swapHotPages(hot, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+/**
+ * Print the hotTopK largest counters of the passed summary, largest first.
+ * Each count may overestimate the true count by at most the printed error.
+ */
+void printHotPages(HotPages *hot)
+{
+    uint32_t i, j, best;
+    uint32_t numPrinted = hot->size < hotTopK ? hot->size : hotTopK;
+
+    if (hot->size == 0) {
+        printf("  {EMPTY}\n");
+        return;
+    }
+
+    // Selection over a copy of the counts, only done when reporting.
+    unsigned long long *counts = malloc(hot->size * sizeof(unsigned long long));
+    memcpy(counts, hot->counts, hot->size * sizeof(unsigned long long));
+
+    for (i = 0; i < numPrinted; i++) {
+        best = 0;
+        for (j = 1; j < hot->size; j++) {
+            if (counts[j] > counts[best]) {
+                best = j;
+            }
+        }
+
+        // The section header names the trace, so drop its tag from merged page numbers.
+        printf("  0x%08x %llu (error <= %llu)\n", hot->pages[best] & ((1u << TRACE_SHIFT) - 1),
+            hot->counts[best], hot->errors[best]);
+        counts[best] = 0;
+    }
+
+    free(counts);
+}
+
+// Print the hot pages of every process since the last report, then start a new interval.
+void reportHotPages()
+{
+    int i;
+
+    printf("HOT PAGES (events %llu - %llu)\n", hotIntervalStart, numEvents);
+    for (i = 0; i < numProcesses; i++) {
+        printf("Process %d most faulted pages:\n", i);
+        printHotPages(&hotFaults[i]);
+        printf("Process %d most written back pages:\n", i);
+        printHotPages(&hotWrites[i]);
+
+        freeHotPages(&hotFaults[i]);
+        freeHotPages(&hotWrites[i]);
+        hotFaults[i] = initHotPages(hotCounters);
+        hotWrites[i] = initHotPages(hotCounters);
+    }
+
+    hotIntervalStart = numEvents + 1;
+}
+
+// Free the arrays of the passed summary.
+void freeHotPages(HotPages *hot)
+{
+    free(hot->pages);
+    free(hot->counts);
+    free(hot->errors);
+    freePageMap(&hot->slots);
+}
+
+/**
+ * Write a snapshot of the whole simulation to the passed file. The snapshot is
+ * written next to it first and renamed over it, so an interruption never leaves
+ * a torn checkpoint behind.
+ */
+bool saveCheckpoint(char *fileName)
+{
+    CheckpointHeader header;
+    char *tmpName = malloc(strlen(fileName) + 5);
+    bool saved;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    strncpy(header.policy, replacementPolicy, sizeof(header.policy) - 1);
+    header.numFrames = numFrames;
+    header.numTraces = numTraces;
+    header.mergeOrder = mergeOrder;
+    header.localReplacement = localReplacement;
+    header.hasPrefetchBits = prefetchMode != PREFETCH_NONE;
+    header.denseMode = denseMode;
+    header.hotCounters = hotCounters;
+    header.numEvents = numEvents;
+
+    sprintf(tmpName, "%s.tmp", fileName);
+    checkpointOut = fopen(tmpName, "wb");
+    if (checkpointOut == NULL) {
+        printf("Failed to write checkpoint %s.\n", tmpName);
+        free(tmpName);
+        return false;
+    }
+
+    saved = transfer(&header, sizeof(header)) && transferState(&header);
+    saved = fclose(checkpointOut) == 0 && saved;
+    checkpointOut = NULL;
+
+    if (!saved || rename(tmpName, fileName) != 0) {
+        printf("Failed to write checkpoint %s.\n", fileName);
+        remove(tmpName);
+        saved = false;
+    }
+
+    free(tmpName);
+    return saved;
+}
+
+/**
+ * Restore the simulation from the passed snapshot. The file is mapped with a single
+ * read only mmap and the state copied out of it, so any number of runs can fork
+ * from the same warmed up snapshot while sharing its pages in the page cache.
+ */
+bool loadCheckpoint(char *fileName)
+{
+    CheckpointHeader header;
+    struct stat fileStat;
+    char *snapshot;
+    bool loaded = false;
+    int fd = open(fileName, O_RDONLY);
+
+    if (fd < 0 || fstat(fd, &fileStat) != 0 || (size_t) fileStat.st_size < sizeof(header)) {
+        printf("Failed to open checkpoint %s.\n", fileName);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return false;
+    }
+
+    snapshot = mmap(NULL, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (snapshot == MAP_FAILED) {
+        printf("Failed to map checkpoint %s.\n", fileName);
+        return false;
+    }
+
+    checkpointCursor = snapshot;
+    checkpointEnd = snapshot + fileStat.st_size;
+    transfer(&header, sizeof(header));
+
+    if (memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0
+        || header.version != CHECKPOINT_VERSION) {
+        printf("%s is not a checkpoint of this version of memsim.\n", fileName);
+    }
+    else if (header.numTraces != numTraces || header.mergeOrder != mergeOrder
+        || header.localReplacement != localReplacement || header.denseMode != denseMode) {
+        printf("Checkpoint was taken with a different trace list, merge order, -local or -dense: "
+        "%d traces.\n", header.numTraces);
+    }
+    else if (!transferState(&header)) {
+        printf("Checkpoint %s is truncated or was taken on different trace files or weights.\n", fileName);
+    }
+    else {
+        loaded = true;
+    }
+
+    munmap(snapshot, fileStat.st_size);
+    return loaded;
+}
+
+/**
+ * Save or load everything that changes while simulating, depending on whether
+ * checkpointOut is open. The page table index and hot page slot maps are not
+ * stored, they are rebuilt from the arrays they index after loading.
+ */
+bool transferState(CheckpointHeader *header)
+{
+    bool loading = checkpointOut == NULL;
+    bool exact = strncmp(header->policy, replacementPolicy, sizeof(header->policy)) == 0
+        && header->numFrames == numFrames;
+    bool ok = true;
+    int i, j, weight;
+    uint64_t offset;
+
+    ok = ok && transfer(&numEvents, sizeof(numEvents));
+    ok = ok && transfer(&numReads, sizeof(numReads));
+    ok = ok && transfer(&numWrites, sizeof(numWrites));
+    ok = ok && transfer(&prefetchReads, sizeof(prefetchReads));
+    ok = ok && transfer(&usefulPrefetches, sizeof(usefulPrefetches));
+    ok = ok && transfer(&rngState, sizeof(rngState));
+    ok = ok && transfer(&backgroundWrites, sizeof(backgroundWrites));
+
+    // Device state. Channels are only carried over to a run with the same queue depth.
+    int depth = ioDepth;
+    ok = ok && transfer(&simTime, sizeof(simTime));
+    ok = ok && transfer(&stallTime, sizeof(stallTime));
+    ok = ok && transfer(&lastReadPage, sizeof(lastReadPage));
+    ok = ok && transfer(&lastWritePage, sizeof(lastWritePage));
+    ok = ok && transfer(&depth, sizeof(depth)) && depth > 0;
+    ok = ok && transferOptional(depth == ioDepth ? channelFree : NULL, depth * sizeof(double), true);
+
+    // Trace cursors and the merge between them.
+    for (i = 0; ok && i < numTraces; i++) {
+        TraceReader *reader = &traces[i];
+        uint64_t fileSize = reader->fileSize;
+        int64_t modifiedSec = reader->modifiedSec, modifiedNsec = reader->modifiedNsec;
+
+        // Offsets only make sense in the very trace the checkpoint was taken on.
+        ok = ok && transfer(&fileSize, sizeof(fileSize)) && fileSize == reader->fileSize;
+        ok = ok && transfer(&modifiedSec, sizeof(modifiedSec)) && modifiedSec == reader->modifiedSec;
+        ok = ok && transfer(&modifiedNsec, sizeof(modifiedNsec)) && modifiedNsec == reader->modifiedNsec;
+
+        weight = reader->weight;
+        ok = ok && transfer(&weight, sizeof(weight)) && weight == reader->weight;
+
+        offset = ftell(reader->file);
+        ok = ok && transfer(&offset, sizeof(offset));
+        ok = ok && transfer(&reader->next, sizeof(reader->next));
+        ok = ok && transfer(&reader->hasNext, sizeof(reader->hasNext));
+        ok = ok && transfer(&reader->numRecords, sizeof(reader->numRecords));
+        ok = ok && transfer(&reader->numLines, sizeof(reader->numLines));
+        ok = ok && transfer(&reader->numEvents, sizeof(reader->numEvents));
+        ok = ok && transfer(&reader->numReads, sizeof(reader->numReads));
+        ok = ok && transfer(&reader->numWrites, sizeof(reader->numWrites));
+        ok = ok && transfer(&reader->recordsLeft, sizeof(reader->recordsLeft));
+
+        if (ok && loading) {
+            ok = fseek(reader->file, offset, SEEK_SET) == 0;
+        }
+    }
+    ok = ok && transfer(&heapSize, sizeof(heapSize));
+    ok = ok && transfer(mergeHeap, numTraces * sizeof(int));
+    ok = ok && transfer(&currTrace, sizeof(currTrace));
+    ok = ok && transfer(&burstLeft, sizeof(burstLeft));
+
+    // IDs handed out to prefetched pages that are not in any trace.
+    uint32_t numIds = numDensePages;
+    ok = ok && transfer(&numIds, sizeof(numIds)) && numIds >= numTracePages;
+    if (ok && loading) {
+        growDensePages(numIds);
+        numDensePages = numIds;
+    }
+    ok = ok && transfer(densePages + numTracePages, (size_t) (numIds - numTracePages) * sizeof(uint32_t));
+    for (j = numTracePages; ok && loading && (uint32_t) j < numIds && denseIds.keys != NULL; j++) {
+        mapPut(&denseIds, densePages[j], j);
+    }
+
+    // Resident pages of every partition in eviction order, which any policy and frame count can be rebuilt from.
+    for (i = 0; ok && i < numPartitions; i++) {
+        ok = transferResident(&partitions[i], exact);
+    }
+
+    ok = ok && transfer(prefetchers, numProcesses * sizeof(Prefetcher));
+
+    // Hot page summaries, only carried over between runs using the same number of counters.
+    ok = ok && transfer(&hotIntervalStart, sizeof(hotIntervalStart));
+    for (i = 0; ok && header->hotCounters > 0 && i < 2 * numProcesses; i++) {
+        HotPages *hot = header->hotCounters == hotCounters
+            ? (i < numProcesses ? &hotFaults[i] : &hotWrites[i - numProcesses]) : NULL;
+        uint32_t size = hot != NULL ? hot->size : 0;
+
+        ok = ok && transfer(&size, sizeof(size)) && size <= header->hotCounters;
+        ok = ok && transferOptional(hot != NULL ? hot->pages : NULL, size * sizeof(uint32_t), true);
+        ok = ok && transferOptional(hot != NULL ? hot->counts : NULL, size * sizeof(unsigned long long), true);
+        ok = ok && transferOptional(hot != NULL ? hot->errors : NULL, size * sizeof(unsigned long long), true);
+
+        if (ok && loading && hot != NULL) {
+            hot->size = size;
+            for (j = 0; (uint32_t) j < size; j++) {
+                mapPut(&hot->slots, hot->pages[j], j);
+            }
+        }
+    }
+
+    // The exact frames and policy lists come last, and only runs with the snapshot's policy and frame count restore them.
+    for (i = 0; ok && exact && i < numPartitions; i++) {
+        Partition *part = &partitions[i];
+        PageTable *pageTable = &part->pageTable;
+        size_t bitBytes = ((size_t) pageTable->numFrames + 63) / 64 * sizeof(uint64_t);
+
+        ok = ok && transfer(&pageTable->numEntries, sizeof(pageTable->numEntries));
+        ok = ok && transfer(&pageTable->isFull, sizeof(pageTable->isFull));
+        ok = ok && transfer(pageTable->pageNums, (size_t) pageTable->numFrames * sizeof(uint32_t));
+        if (pageTable->pageIds != NULL) {
+            ok = ok && transfer(pageTable->pageIds, (size_t) pageTable->numFrames * sizeof(uint32_t));
+        }
+        ok = ok && transfer(pageTable->dirtyBits, bitBytes);
+        ok = ok && transferOptional(pageTable->prefetchBits, bitBytes, header->hasPrefetchBits);
+        ok = ok && transfer(&part->nextPageToRemove, sizeof(part->nextPageToRemove));
+
+        if (part->links.prev != NULL) {
+            ok = ok && transfer(part->links.prev, (size_t) part->links.numSlots * sizeof(uint32_t));
+            ok = ok && transfer(part->links.next, (size_t) part->links.numSlots * sizeof(uint32_t));
+        }
+        if (part->links.listOf != NULL) {
+            ok = ok && transfer(part->links.listOf, part->links.numSlots);
+        }
+        ok = ok && transfer(&part->recencyList.numNodes, sizeof(part->recencyList.numNodes));
+        ok = ok && transfer(&part->clean.numNodes, sizeof(part->clean.numNodes));
+        ok = ok && transfer(&part->dirty.numNodes, sizeof(part->dirty.numNodes));
+        for (j = 0; ok && part->fifos != NULL && j < part->numProcesses; j++) {
+            ok = ok && transfer(&part->fifos[j].numNodes, sizeof(part->fifos[j].numNodes));
+        }
+
+        if (ok && loading) {
+            if (pageTable->index != NULL) {
+                memset(pageTable->index, 0xFF, (size_t) pageTable->indexSize * sizeof(uint32_t));
+            }
+            for (j = 0; (uint32_t) j < pageTable->numEntries; j++) {
+                if (pageTable->pageIds != NULL) {
+                    frameOf[pageTable->pageIds[j]] = j;
+                }
+                else {
+                    indexInsert(pageTable, j);
+                }
+            }
+
+            pageTable->numDirty = 0;
+            for (j = 0; (size_t) j < bitBytes / sizeof(uint64_t); j++) {
+                pageTable->numDirty += __builtin_popcountll(pageTable->dirtyBits[j]);
+            }
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * Save or load the resident pages of the passed partition, listed in the order
+ * its policy would evict them. A run restoring the exact state skips them. Any
+ * other run rebuilds the partition from them, and with fewer frames first drops
+ * the pages the snapshot's policy would have evicted first, without writing them back.
+ */
+bool transferResident(Partition *part, bool exact)
+{
+    PageTable *pageTable = &part->pageTable;
+    ResidentPage *pages;
+    uint32_t *order, numResident, i;
+    bool ok;
+
+    if (checkpointOut != NULL) {
+        order = malloc(((size_t) pageTable->numEntries + 1) * sizeof(uint32_t));
+        pages = calloc((size_t) pageTable->numEntries + 1, sizeof(ResidentPage));
+        numResident = getEvictionOrder(part, order);
+
+        for (i = 0; i < numResident; i++) {
+            pages[i].pageNum = pageTable->pageNums[order[i]];
+            pages[i].pageId = pageTable->pageIds != NULL ? pageTable->pageIds[order[i]] : EMPTY_PAGE;
+            pages[i].dirty = isDirty(pageTable, order[i]);
+            pages[i].prefetched = pageTable->prefetchBits != NULL && getBit(pageTable->prefetchBits, order[i]);
+        }
+
+        ok = transfer(&numResident, sizeof(numResident))
+            && transfer(pages, (size_t) numResident * sizeof(ResidentPage));
+        free(order);
+        free(pages);
+        return ok;
+    }
+
+    if (!transfer(&numResident, sizeof(numResident))
+        || (size_t) (checkpointEnd - checkpointCursor) / sizeof(ResidentPage) < numResident) {
+        return false;
+    }
+    if (exact) {
+        return transferOptional(NULL, (size_t) numResident * sizeof(ResidentPage), true);
+    }
+
+    pages = malloc(((size_t) numResident + 1) * sizeof(ResidentPage));
+    ok = transfer(pages, (size_t) numResident * sizeof(ResidentPage));
+
+    i = numResident > pageTable->numFrames ? numResident - pageTable->numFrames : 0;
+    for (; ok && i < numResident; i++) {
+        ok = pageTable->pageIds == NULL || pages[i].pageId < numDensePages;
+        if (ok) {
+            restorePage(part, &pages[i]);
+        }
+    }
+
+    free(pages);
+    return ok;
+}
+
+// Fill order with the resident frames of the passed partition, first evicted first, and return their number.
+uint32_t getEvictionOrder(Partition *part, uint32_t *order)
+{
+    PageTable *pageTable = &part->pageTable;
+    DLinkedList *lists[2] = { &part->clean, &part->dirty };
+    uint32_t numResident = 0, frame;
+    int i;
+
+    if (policy == lru) {
+        DLinkedList *list = &part->recencyList;
+        for (frame = list->links->prev[list->trailer]; frame != list->header; frame = list->links->prev[frame]) {
+            order[numResident++] = frame;
+        }
+    }
+    // VMS reclaims the clean list, then the dirty list, then a process' own FIFO.
+    else if (policy == vms) {
+        for (i = 0; i < 2 + part->numProcesses; i++) {
+            DLinkedList *list = i < 2 ? lists[i] : &part->fifos[i - 2];
+            for (frame = list->links->prev[list->trailer]; frame != list->header; frame = list->links->prev[frame]) {
+                order[numResident++] = frame;
+            }
+        }
+    }
+    // FIFO evicts from nextPageToRemove on once full, random replacement has no order.
+    else {
+        for (i = 0; (uint32_t) i < pageTable->numEntries; i++) {
+            frame = policy == fifo && pageTable->isFull ? part->nextPageToRemove + i : i;
+            order[numResident++] = frame < pageTable->numFrames ? frame : frame - pageTable->numFrames;
+        }
+    }
+
+    return numResident;
+}
+
+/**
+ * Place the passed page in the next free frame of the passed partition, behind the
+ * pages restored before it in the policy's order. Nothing is read from disk.
+ */
+void restorePage(Partition *part, ResidentPage *page)
+{
+    PageTable *pageTable = &part->pageTable;
+    uint32_t frame = pageTable->numEntries;
+    Event event;
+
+    memset(&event, 0, sizeof(event));
+    event.pageNum = page->pageNum;
+    event.pageId = page->pageId;
+    event.process = getOwner(page->pageNum);
+
+    setPage(pageTable, frame, &event);
+    setDirty(pageTable, frame, page->dirty);
+    if (pageTable->prefetchBits != NULL) {
+        setBit(pageTable->prefetchBits, frame, page->prefetched);
+    }
+
+    if (policy == lru) {
+        addFront(&part->recencyList, frame);
+    }
+    else if (policy == vms) {
+        DLinkedList *fifo = &part->fifos[part->numProcesses == 1 ? 0 : event.process];
+
+        // Like a fault, prefetched pages wait on the clean list and a full resident set demotes its first-in page.
+        if (page->prefetched) {
+            addFront(&part->clean, frame);
+        }
+        else {
+            addFront(fifo, frame);
+            if (fifo->numNodes > part->rss) {
+                vmsDemote(part, fifo);
+            }
+        }
+    }
+
+    pageTable->numEntries++;
+    if (pageTable->numEntries == pageTable->numFrames) {
+        pageTable->isFull = true;
+    }
+}
+
+// Write the passed block to the checkpoint being saved, or fill it from the snapshot being loaded.
+bool transfer(void *data, size_t bytes)
+{
+    // Empty blocks may have no array behind them.
+    if (bytes == 0) {
+        return true;
+    }
+
+    if (checkpointOut != NULL) {
+        return fwrite(data, 1, bytes, checkpointOut) == bytes;
+    }
+
+    if ((size_t) (checkpointEnd - checkpointCursor) < bytes) {
+        return false;
+    }
+
+    memcpy(data, checkpointCursor, bytes);
+    checkpointCursor += bytes;
+    return true;
+}
+
+/**
+ * Transfer a block only one side may have. Saving writes it when data exists. Loading
+ * reads it when the snapshot has it, skipping it if this run has nowhere to put it.
+ */
+bool transferOptional(void *data, size_t bytes, bool inSnapshot)
+{
+    if (checkpointOut != NULL) {
+        return data == NULL || transfer(data, bytes);
+    }
+
+    if (!inSnapshot) {
+        return true;
+    }
+
+    if (data != NULL) {
+        return transfer(data, bytes);
+    }
+
+    if ((size_t) (checkpointEnd - checkpointCursor) < bytes) {
+        return false;
+    }
+    checkpointCursor += bytes;
+    return true;
+}
+
+// Seed the random number generator used by random replacement.
+void seedRandom(uint64_t seed)
+{
+    // One splitmix64 step, so that nearby seeds give unrelated, nonzero states.
+    seed += 0x9E3779B97F4A7C15ULL;
+    seed = (seed ^ (seed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    seed = (seed ^ (seed >> 27)) * 0x94D049BB133111EBULL;
+    rngState = (seed ^ (seed >> 31)) | 1;
+}
+
+// Return the next number of the xorshift64* generator. Its whole state is rngState, so it can be checkpointed.
+uint32_t nextRandom()
+{
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return (rngState * 0x2545F4914F6CDD1DULL) >> 32;
+}
+
+/**
+ * Characterize the merged trace in one streaming pass and print the result as JSON.
+ *
+ * Reuse distance, the number of distinct pages referenced since the last reference
+ * to the same page, is counted with a Fenwick tree over the timeline holding a 1 at
+ * each page's latest reference. The timeline is compacted whenever it fills, so it
+ * stays proportional to the number of unique pages rather than the trace length.
+ *
+ * Each working set window W(t, tau) is tracked with its own ring buffer. With -sample
+ * its value is also recorded every that many events.
+ */
+void analyze()
+{
+    unsigned long long histogram[REUSE_BUCKETS] = { 0 };
+    unsigned long long coldMisses = 0;
+    uint32_t timelineSize = MIN_TIMELINE, time = 0;
+    uint32_t *tree = allocArray(((size_t) timelineSize + 1) * sizeof(uint32_t));
+    uint32_t *pageAt = allocArray(((size_t) timelineSize + 1) * sizeof(uint32_t));
+    PageMap lastAccess = initPageMap(MIN_TIMELINE / 2);
+    uint32_t *last, distance, *count, oldest;
+    int bucket, i;
+    bool firstSample = true;
+    Event event;
+
+    // Samples are written to a temporary file as they are taken and copied into the output at the end.
+    FILE *samples = sampleInterval > 0 ? tmpfile() : NULL;
+
+    while (nextEvent(&event)) {
+        numEvents++;
+
+        // Reuse distance.
+        last = mapFind(&lastAccess, event.pageNum);
+        if (last == NULL) {
+            coldMisses++;
+        }
+        else {
+            distance = fenwickSum(tree, time) - fenwickSum(tree, *last);
+            for (bucket = 0; distance > 0; bucket++) {
+                distance >>= 1;
+            }
+            histogram[bucket]++;
+
+            fenwickAdd(tree, timelineSize, *last, -1);
+            pageAt[*last] = EMPTY_PAGE;
+        }
+
+        if (time == timelineSize) {
+            time = compactTimeline(&tree, &pageAt, &timelineSize, &lastAccess);
+        }
+
+        time++;
+        fenwickAdd(tree, timelineSize, time, 1);
+        pageAt[time] = event.pageNum;
+        mapPut(&lastAccess, event.pageNum, time);
+
+        // Working set windows.
+        for (i = 0; i < numWindows; i++) {
+            WorkingSet *window = &windows[i];
+
+            if (numEvents > window->size) {
+                oldest = window->ring[window->head];
+                count = mapFind(&window->counts, oldest);
+                if (--*count == 0) {
+                    mapRemove(&window->counts, oldest);
+                }
+            }
+
+            window->ring[window->head] = event.pageNum;
+            if (++window->head == window->size) {
+                window->head = 0;
+            }
+
+            count = mapFind(&window->counts, event.pageNum);
+            if (count != NULL) {
+                (*count)++;
+            }
+            else {
+                mapPut(&window->counts, event.pageNum, 1);
+            }
+
+            window->sum += window->counts.count;
+            if (window->counts.count > window->max) {
+                window->max = window->counts.count;
+            }
+        }
+
+        if (samples != NULL && numEvents % sampleInterval == 0) {
+            fprintf(samples, "%s[%llu", firstSample ? "" : ", ", numEvents);
+            for (i = 0; i < numWindows; i++) {
+                fprintf(samples, ", %u", windows[i].counts.count);
+            }
+            fprintf(samples, "]");
+            firstSample = false;
+        }
+    }
+
+    printf("{\n");
+    printf("  \"events\": %llu,\n", numEvents);
+    printf("  \"unique_pages\": %u,\n", lastAccess.count);
+    printf("  \"reuse_distance\": {\n");
+    printf("    \"cold\": %llu,\n", coldMisses);
+    printf("    \"buckets\": [");
+    for (bucket = 0; bucket < REUSE_BUCKETS; bucket++) {
+        printf("%s\n      {\"min\": %llu, \"max\": %llu, \"count\": %llu}", bucket == 0 ? "" : ",",
+            bucket == 0 ? 0 : 1ULL << (bucket - 1), bucket == 0 ? 0 : (1ULL << bucket) - 1, histogram[bucket]);
+    }
+    printf("\n    ]\n");
+    printf("  },\n");
+    printf("  \"working_set\": [");
+    for (i = 0; i < numWindows; i++) {
+        printf("%s\n    {\"window\": %u, \"mean\": %.2f, \"max\": %u}", i == 0 ? "" : ",",
+            windows[i].size, numEvents == 0 ? 0.0 : (double) windows[i].sum / numEvents, windows[i].max);
+    }
+    printf("\n  ]");
+
+    // Each sample is [t, W(t, w1), W(t, w2), ...] in the order of the windows above.
+    if (samples != NULL) {
+        char buffer[LINE_LEN];
+        size_t length;
+
+        printf(",\n  \"samples\": [");
+        rewind(samples);
+        while ((length = fread(buffer, 1, LINE_LEN, samples)) > 0) {
+            fwrite(buffer, 1, length, stdout);
+        }
+        printf("]");
+        fclose(samples);
+    }
+    printf("\n}\n");
+
+    freeWindows();
+    freeArray(tree, ((size_t) timelineSize + 1) * sizeof(uint32_t));
+    freeArray(pageAt, ((size_t) timelineSize + 1) * sizeof(uint32_t));
+    freePageMap(&lastAccess);
+}
+
+// Parse the comma separated working set window sizes and set up a ring buffer for each.
+bool parseWindows(char *windowList)
+{
+    char *window;
+    uint32_t size;
+
+    numWindows = 1;
+    for (window = windowList; *window != '\0'; window++) {
+        if (*window == ',') {
+            numWindows++;
+        }
+    }
+
+    windows = calloc(numWindows, sizeof(WorkingSet));
+
+    numWindows = 0;
+    window = strtok(windowList, ",");
+    while (window != NULL) {
+        if (sscanf(window, "%u", &size) != 1 || size == 0) {
+            printf("Window sizes must be positive.\n");
+            freeWindows();
+            return false;
+        }
+
+        windows[numWindows].size = size;
+        windows[numWindows].ring = allocArray((size_t) size * sizeof(uint32_t));
+        windows[numWindows].counts = initPageMap(size < MIN_TIMELINE ? size : MIN_TIMELINE);
+        numWindows++;
+
+        window = strtok(NULL, ",");
+    }
+
+    return true;
+}
+
+// Free the working set windows set up so far.
+void freeWindows()
+{
+    int i;
+    for (i = 0; i < numWindows; i++) {
+        freeArray(windows[i].ring, (size_t) windows[i].size * sizeof(uint32_t));
+        freePageMap(&windows[i].counts);
+    }
+    free(windows);
+}
+
+/**
+ * Called when the timeline is full. Renumber the latest reference of every page
+ * 1..U in the same order, which keeps every reuse distance intact, and rebuild
+ * the Fenwick tree over them. The timeline doubles if U would fill over half of
+ * it. Returns U, the last position in use.
+ */
+uint32_t compactTimeline(uint32_t **tree, uint32_t **pageAt, uint32_t *timelineSize, PageMap *lastAccess)
+{
+    uint32_t oldSize = *timelineSize;
+    uint32_t newSize = lastAccess->count > oldSize / 2 ? oldSize * 2 : oldSize;
+    uint32_t *newTree = allocArray(((size_t) newSize + 1) * sizeof(uint32_t));
+    uint32_t *newPageAt = allocArray(((size_t) newSize + 1) * sizeof(uint32_t));
+    uint32_t pos, parent, numLive = 0;
+
+    for (pos = 1; pos <= oldSize; pos++) {
+        if ((*pageAt)[pos] != EMPTY_PAGE) {
+            numLive++;
+            newPageAt[numLive] = (*pageAt)[pos];
+            *mapFind(lastAccess, (*pageAt)[pos]) = numLive;
+        }
+    }
+
+    // Build the tree over numLive ones in linear time by pushing each node into its parent.
+    for (pos = 1; pos <= newSize; pos++) {
+        newTree[pos] += pos <= numLive ? 1 : 0;
+        parent = pos + (pos & -pos);
+        if (parent <= newSize) {
+            newTree[parent] += newTree[pos];
+        }
+    }
+
+    freeArray(*tree, ((size_t) oldSize + 1) * sizeof(uint32_t));
+    freeArray(*pageAt, ((size_t) oldSize + 1) * sizeof(uint32_t));
+    *tree = newTree;
+    *pageAt = newPageAt;
+    *timelineSize = newSize;
+
+    return numLive;
+}
+
+// Add delta at position i of the passed 1-based Fenwick tree.
+void fenwickAdd(uint32_t *tree, uint32_t size, uint32_t i, int delta)
+{
+    for (; i <= size; i += i & -i) {
+        tree[i] += delta;
+    }
+}
+
+// Return the sum of positions 1..i of the passed Fenwick tree.
+uint32_t fenwickSum(uint32_t *tree, uint32_t i)
+{
+    uint32_t sum = 0;
+
+    for (; i > 0; i -= i & -i) {
+        sum += tree[i];
+    }
+
+    return sum;
+}
+
+/**
+ * Write back daemon. When fewer than wbLowMark frames of the passed partition are
+ * clean, write back up to wbBatch dirty pages, looking at pages in the order the
+ * policy would evict them: the dirty list for vms, least recent first for lru,
+ * from the next victim onwards for fifo, and behind a clock hand for rdm. For vms
+ * only the clean list counts as clean, since it is what faults are served from.
+ */
+void cleanPages(Partition *part)
+{
+    PageTable *pageTable = &part->pageTable;
+    uint32_t clean = policy == vms ? part->clean.numNodes : pageTable->numFrames - pageTable->numDirty;
+    uint32_t scanned, written = 0;
+    uint32_t frame;
+
+    if (clean >= wbLowMark) {
+        return;
+    }
+
+    wbBatchStarted = false;
+
+    if (policy == vms) {
+        // Cleaned pages move to the clean list, behind the pages already there.
+        while (written < wbBatch && part->dirty.numNodes > 0) {
+            frame = getLeastRecent(&part->dirty);
+            rmBack(&part->dirty);
+            writeBack(part, frame);
+            addFront(&part->clean, frame);
+            written++;
+        }
+        return;
+    }
+
+    frame = policy == lru ? part->links.prev[part->recencyList.trailer] : part->nextPageToRemove;
+    for (scanned = 0; written < wbBatch && scanned < WB_SCAN_FACTOR * wbBatch
+        && scanned < pageTable->numFrames; scanned++) {
+        if (isDirty(pageTable, frame)) {
+            writeBack(part, frame);
+            written++;
+        }
+
+        if (policy == lru) {
+            frame = part->links.prev[frame];
+        }
+        else if (++frame == pageTable->numFrames) {
+            frame = 0;
+        }
+    }
+
+    // Random replacement keeps no eviction order, so its scan resumes where it stopped.
+    if (policy == rdm) {
+        part->nextPageToRemove = frame;
+    }
+}
+
+// Write the page in the passed frame back in the background and mark it clean.
+void writeBack(Partition *part, uint32_t frame)
+{
+    diskWrite(part->pageTable.pageNums[frame], NULL);
+    setDirty(&part->pageTable, frame, false);
+}
+
+/**
+ * Queue an I/O of the passed latency on the channel that frees up first and return
+ * the time it completes. It costs ioDiscount of its latency when it continues the
+ * previous I/O of its kind at the next page, or when discounted is set.
+ */
+double submitIO(double latency, uint32_t pageNum, uint32_t *lastPage, bool discounted)
+{
+    int i, channel = 0;
+    double start;
+
+    if (discounted || pageNum == *lastPage + 1) {
+        latency *= ioDiscount;
+    }
+    *lastPage = pageNum;
+
+    for (i = 1; i < ioDepth; i++) {
+        if (channelFree[i] < channelFree[channel]) {
+            channel = i;
+        }
+    }
+
+    start = channelFree[channel] > simTime ? channelFree[channel] : simTime;
+    channelFree[channel] = start + latency;
+    return channelFree[channel];
+}
+
+// Block the simulated process until the passed time.
+void stallUntil(double finish)
+{
+    if (finish > simTime) {
+        stallTime += finish - simTime;
+        simTime = finish;
+    }
+}
+
+/**
+ * Run the enabled prefetchers after a demand miss or a first reference to a
+ * prefetched page. Detection is O(1) per event, and each page is only issued
+ * once per sequential stream since raEnd remembers how far ahead it was read.
+ */
+void prefetch(Partition *part, Event *event)
+{
+    Prefetcher *prefetcher = &prefetchers[event->process];
+    uint32_t page = getPageNum(event->address);
+    int64_t delta;
+    int i;
+
+    if (prefetchMode & PREFETCH_SEQ) {
+        // Sequential read-ahead. The window doubles while the stream stays sequential.
+        if (page == prefetcher->lastPage + 1) {
+            prefetcher->window = prefetcher->window == 0 ? RA_INIT_WINDOW : prefetcher->window * 2;
+            if (prefetcher->window > raMaxWindow) {
+                prefetcher->window = raMaxWindow;
+            }
+
+            if (prefetcher->raEnd < page || prefetcher->raEnd > page + prefetcher->window) {
+                prefetcher->raEnd = page;
+            }
+
+            // Issue the furthest page first so the nearest ends up most recently placed.
+            for (delta = page + prefetcher->window - prefetcher->raEnd; delta > 0; delta--) {
+                prefetchPage(part, event, prefetcher->raEnd + delta - page);
+            }
+            prefetcher->raEnd = page + prefetcher->window;
+        }
+        else {
+            prefetcher->window = 0;
+            prefetcher->raEnd = page;
+        }
+
+        prefetcher->lastPage = page;
+    }
+
+    if (prefetchMode & PREFETCH_STRIDE) {
+        // Stride detection. Unit strides are left to read-ahead.
+        delta = (int64_t) page - prefetcher->lastMiss;
+
+        if (delta == prefetcher->stride && delta != 0) {
+            prefetcher->confidence++;
+        }
+        else {
+            prefetcher->stride = delta;
+            prefetcher->confidence = 0;
+        }
+        prefetcher->lastMiss = page;
+
+        // Once the same stride was seen twice in a row, fetch the next strideDepth pages along it.
+        bool unitStride = delta == 1 && (prefetchMode & PREFETCH_SEQ);
+        if (prefetcher->confidence >= 1 && !unitStride) {
+            for (i = strideDepth; i > 0; i--) {
+                prefetchPage(part, event, prefetcher->stride * i);
+            }
+        }
+    }
+}
+
+/**
+ * Prefetch the page delta pages away from the page of the passed event,
+ * unless it lies outside the event's page space or is already resident.
+ */
+void prefetchPage(Partition *part, Event *event, int64_t delta)
+{
+    int64_t page = (int64_t) getPageNum(event->address) + delta;
+    Event prefetchEvent = *event;
+
+    if (page < 0 || page >= (1 << TRACE_SHIFT)) {
+        return;
+    }
+
+    // A single trace must not prefetch into the other process' half of the address space.
+    prefetchEvent.address = (uint32_t) page << 12;
+    if (numTraces == 1 && (getProcess(prefetchEvent.address) == PROCESS_B ? 1 : 0) != event->process) {
+        return;
+    }
+
+    prefetchEvent.pageNum = (event->pageNum & ~((1u << TRACE_SHIFT) - 1)) | (uint32_t) page;
+    prefetchEvent.rw = 'R';
+    prefetchEvent.prefetch = true;
+
+    if (denseMode) {
+        prefetchEvent.pageId = getDenseId(prefetchEvent.pageNum);
+    }
+
+    if (findEntry(&part->pageTable, &prefetchEvent) == NO_FRAME) {
+        policy(part, &prefetchEvent, NO_FRAME);
+    }
+}
+
+// Random replacement policy simulation.
+void rdm(Partition *part, Event *event, uint32_t frame)
+{
+    PageTable *pageTable = &part->pageTable;
+    uint32_t randIndex = 0;
+
+    // If its found, update its dirty bit if its written to.
+    if (frame != NO_FRAME) {
+        if (event->rw == 'W') {
+            setDirty(pageTable, frame, true);
+        }
+    }
+    // Otherwise, page fault occured.
+    else {
+        // While page table is not full, fill entry by entry.
+        if (!pageTable->isFull) {
+            setPage(pageTable, pageTable->numEntries, event);
+
+            if (event->rw == 'W') {
+                setDirty(pageTable, pageTable->numEntries, true);
+            }
+
+            diskRead(pageTable, pageTable->numEntries, event);
+            pageTable->numEntries++;
+
+            // Swap to replacement policy once pageTable is full.
+            if (pageTable->numEntries == pageTable->numFrames) {
+                pageTable->isFull = true;
+            }
+        }
+        // Replace pages at random.
+        else {
+            randIndex = nextRandom() % pageTable->numFrames;
+
+            if (isDirty(pageTable, randIndex)) {
+                diskWrite(pageTable->pageNums[randIndex], event);
+            }
+
+            setPage(pageTable, randIndex, event);
+            diskRead(pageTable, randIndex, event);
+
+            setDirty(pageTable, randIndex, event->rw == 'W');
+        }
+    }
+}
+
+// Least recenctly used replacement policy simulation.
+void lru(Partition *part, Event *event, uint32_t frame)
+{
+    PageTable *pageTable = &part->pageTable;
+    DLinkedList *recencyList = &part->recencyList;
+    uint32_t pageToRemove;
+
+    // If its found, update its recency and modify its dirty bit accordingly.
+    if (frame != NO_FRAME) {
+        updateRecency(recencyList, frame);
+
+        if (event->rw == 'W') {
+            setDirty(pageTable, frame, true);
+        }
+    }
+    // Otherwise, page fault occured.
+    else {
+        // While page table isnt full.
+        if (!pageTable->isFull) {
+
+            // Add page to next available entry.
+            setPage(pageTable, pageTable->numEntries, event);
+
+            // Set dirty bit accordingly.
+            if (event->rw == 'W') {
+                setDirty(pageTable, pageTable->numEntries, true);
+            }
+
+            // Update recency list to add new page to the front.
+            addFront(recencyList, pageTable->numEntries);
+
+            diskRead(pageTable, pageTable->numEntries, event);
+            pageTable->numEntries++;
+
+            // Swap to replacement policy once full.
+            if (pageTable->numEntries == pageTable->numFrames) {
+                pageTable->isFull = true;
+            }
+        }
+        else {
+            // Remove to page which was accessly least recently. (back of recency list)
+            pageToRemove = getLeastRecent(recencyList);
+
+            if (isDirty(pageTable, pageToRemove)) {
+                diskWrite(pageTable->pageNums[pageToRemove], event);
+            }
+
+            // Place new page into page table, set data members accordingly.
+            setPage(pageTable, pageToRemove, event);
+            diskRead(pageTable, pageToRemove, event);
+            setDirty(pageTable, pageToRemove, event->rw == 'W');
+
+            // Update recency list to move new page to front.
+            updateRecency(recencyList, pageToRemove);
+        }
+    }
+}
+
+// First-in-first-out replacement policy simulation.
+void fifo(Partition *part, Event *event, uint32_t frame)
+{
+    PageTable *pageTable = &part->pageTable;
+
+    // If its found, update its dirty bit if its written to.
+    if (frame != NO_FRAME) {
+        if (event->rw == 'W') {
+            setDirty(pageTable, frame, true);
+        }
+    }
+    // Otherwise, page fault occured.
+    else {
+        // While page table is not full, fill entry by entry.
+        if (!pageTable->isFull) {
+            setPage(pageTable, pageTable->numEntries, event);
+
+            if (event->rw == 'W') {
+                setDirty(pageTable, pageTable->numEntries, true);
+            }
+
+            diskRead(pageTable, pageTable->numEntries, event);
+            pageTable->numEntries++;
+
+            // Swap to replacement policy once pageTable is full.
+            if (pageTable->numEntries == pageTable->numFrames) {
+                pageTable->isFull = true;
+            }
+        }
+        else {
+            /**
+             * Because we placed pages from index 0 to numFrames-1, we can
+             * simply keep track of an index variable and any time we need
+             * to remove a page, simply increment the index variable, which
+             * will preserve the FIFO property.
+             */
+            frame = part->nextPageToRemove;
+
+            if (isDirty(pageTable, frame)) {
+                diskWrite(pageTable->pageNums[frame], event);
+            }
+
+            setPage(pageTable, frame, event);
+            diskRead(pageTable, frame, event);
+
+            setDirty(pageTable, frame, event->rw == 'W');
+
+            part->nextPageToRemove++;
+
+            if (part->nextPageToRemove == pageTable->numFrames) {
+                part->nextPageToRemove = 0;
+            }
+        }
+    }
+}
+
+// Used for VMS. Move the first-in page of the passed process FIFO to the dirty or clean list.
+void vmsDemote(Partition *part, DLinkedList *fifo)
+{
+    uint32_t pageToRemove = getLeastRecent(fifo);
+    rmBack(fifo);
+
+    if (isDirty(&part->pageTable, pageToRemove)) {
+        addFront(&part->dirty, pageToRemove);
+    }
+    else {
+        addFront(&part->clean, pageToRemove);
+    }
+}
+
+/**
+ * VMS replacement policy simulation. Every process gets a FIFO resident set
+ * of rss pages, pages pushed out of a resident set wait on the clean or dirty
+ * list where they can be reclaimed by their process or taken by any faulting process.
+ */
+void vms(Partition *part, Event *event, uint32_t frame)
+{
+    PageTable *pageTable = &part->pageTable;
+    uint32_t pageToRemove;
+
+    // Find the FIFO of the process the current page belongs to.
+    DLinkedList *fifo = &part->fifos[part->numProcesses == 1 ? 0 : event->process];
+
+    // If the page is found, page hit.
+    if (frame != NO_FRAME) {
+        // Remove the page from clean or dirty if its there.
+        if (findNode(&part->dirty, frame) != NO_FRAME) {
+            rmNode(&part->dirty, frame);
+        }
+
+        if (findNode(&part->clean, frame) != NO_FRAME) {
+            rmNode(&part->clean, frame);
+        }
+
+        // If the page is in its FIFO list, update its dirty bit if required.
+        if (findNode(fifo, frame) != NO_FRAME) {
+            if (event->rw == 'W') {
+                setDirty(pageTable, frame, true);
+            }
+        }
+        // If not found, then needs to be added to the process FIFO list.
+        else {
+            addFront(fifo, frame);
+
+            // If adding the page makes it exceed its RSS, remove first-in page, and add it to dirty or clean.
+            if (fifo->numNodes >= part->rss) {
+                vmsDemote(part, fifo);
+            }
+        }
+    }
+    // Otherwise, page fault.
+    else {
+        if (!pageTable->isFull) {
+            // While page table is not full, add page to next available entry.
+            setPage(pageTable, pageTable->numEntries, event);
+
+            if (event->rw == 'W') {
+                setDirty(pageTable, pageTable->numEntries, true);
+            }
+
+            // Prefetched pages wait on the clean list until their process references them.
+            if (event->prefetch) {
+                addFront(&part->clean, pageTable->numEntries);
+            }
+            // If adding the page exceeds a process' RSS, remove first-in page, and add it to dirty or clean.
+            else {
+                addFront(fifo, pageTable->numEntries);
+
+                if (fifo->numNodes > part->rss) {
+                    vmsDemote(part, fifo);
+                }
+            }
+
+            diskRead(pageTable, pageTable->numEntries, event);
+            pageTable->numEntries++;
+
+            // Swap to page replacement once page table is full.
+            if (pageTable->numEntries == pageTable->numFrames) {
+                pageTable->isFull = true;
+            }
+        }
+        else {
+            // First remove from clean if able.
+            if (part->clean.numNodes > 0) {
+                pageToRemove = getLeastRecent(&part->clean);
+                rmBack(&part->clean);
+            }
+            // Otherwise, remove from dirty.
+            else if (part->dirty.numNodes > 0) {
+                pageToRemove = getLeastRecent(&part->dirty);
+                rmBack(&part->dirty);
+            }
+            // Otherwise, remove their own page.
+            else {
+                pageToRemove = getLeastRecent(fifo);
+                rmBack(fifo);
+            }
+
+            if (event->prefetch) {
+                addFront(&part->clean, pageToRemove);
+            }
+            else {
+                addFront(fifo, pageToRemove);
+
+                if (fifo->numNodes > part->rss) {
+                    vmsDemote(part, fifo);
+                }
+            }
+
+            if (isDirty(pageTable, pageToRemove)) {
+                diskWrite(pageTable->pageNums[pageToRemove], event);
+            }
+
+            setPage(pageTable, pageToRemove, event);
+            diskRead(pageTable, pageToRemove, event);
+            setDirty(pageTable, pageToRemove, event->rw == 'W');
+        }
+    }
+}
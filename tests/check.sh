@@ -0,0 +1,119 @@
+#!/bin/sh
+# Compare the disk reads and writes of memsim against tests/golden.txt.
+#
+# Usage: tests/check.sh [memsim]            check every golden line
+#        tests/check.sh --update [memsim]   rewrite the counts of every golden line
+#
+# Each golden line is "<traces> <frames> <policy> <reads> <writes> [background] [options]",
+# with traces a comma separated list of files in tests/traces and background the background
+# disk writes, which runs with the write back daemon must have. A line with error in place of
+# the counts must make memsim fail with a message instead of crashing. Every line is also run with
+# -dense, and lines without options besides -seed are also run on the reduced traces,
+# all of which must give the same counts.
+
+update=false
+if [ "$1" = "--update" ]; then
+    update=true
+    shift
+fi
+
+memsim=${1:-./memsim}
+tests=$(dirname "$0")
+golden="$tests/golden.txt"
+
+# Dense caches and reduced traces are written next to the traces, so work on a copy.
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+cp "$tests"/traces/*.trace "$work"
+
+for trace in "$work"/*.trace; do
+    if ! "$memsim" "$trace" 0 reduce quiet -o "${trace%.trace}.rt" > /dev/null; then
+        echo "FAIL: reducing $trace"
+        exit 1
+    fi
+done
+
+# Print "<reads> <writes> [background]" of a run, or nothing if memsim failed.
+counts()
+{
+    "$memsim" "$@" | awk '/^Total disk reads:/ { r = $4 } /^Total disk writes:/ { w = $4 }
+        /^Background disk writes:/ { b = " " $4 }
+        END { if (r != "" && w != "") print r, w b }'
+}
+
+failed=0
+checked=0
+: > "$work/golden.new"
+
+while read -r traces frames policy reads writes options; do
+    case "$traces" in
+        ''|'#'*)
+            echo "$traces $frames $policy $reads $writes $options" | sed 's/ *$//' >> "$work/golden.new"
+            continue
+            ;;
+    esac
+
+    paths=$(echo "$traces" | sed "s|[^,]*|$work/&|g")
+
+    if [ "$reads" = "error" ]; then
+        options=$(echo "$writes $options" | sed 's/ *$//')
+        echo "$traces $frames $policy error $options" >> "$work/golden.new"
+        for run in plain dense; do
+            extra=
+            [ $run = dense ] && extra=-dense
+            output=$("$memsim" "$paths" "$frames" "$policy" quiet $options $extra)
+            status=$?
+            checked=$((checked + 1))
+            if [ $status -ne 255 ] || [ -z "$output" ]; then
+                echo "FAIL ($run): $traces $frames $policy $options: expected an error, got status $status"
+                failed=$((failed + 1))
+            fi
+        done
+        continue
+    fi
+
+    # Options start with a dash, so a leading number is the background writes.
+    background=
+    case "$options" in
+        [0-9]*)
+            background=" ${options%% *}"
+            options=$(echo "$options" | sed 's/^[0-9]* *//')
+            ;;
+    esac
+
+    got=$(counts "$paths" "$frames" "$policy" quiet $options)
+
+    if $update; then
+        echo "$traces $frames $policy $got $options" | sed 's/ *$//' >> "$work/golden.new"
+        continue
+    fi
+
+    # Reduced traces cannot be merged, prefetched or cleaned in the background.
+    runs="plain dense"
+    if [ -z "$(echo "$traces $options" | sed 's/-seed [0-9]*//; s/[^,-]//g')" ]; then
+        runs="$runs reduced"
+    fi
+
+    for run in $runs; do
+        case $run in
+            plain) ;;
+            dense) got=$(counts "$paths" "$frames" "$policy" quiet $options -dense) ;;
+            reduced) got=$(counts "$(echo "$paths" | sed 's/\.trace/.rt/g')" "$frames" "$policy" quiet $options) ;;
+        esac
+
+        checked=$((checked + 1))
+        if [ "$got" != "$reads $writes$background" ]; then
+            echo "FAIL ($run): $traces $frames $policy $options: expected $reads $writes$background, got ${got:-an error}"
+            failed=$((failed + 1))
+        fi
+    done
+done < "$golden"
+
+if $update; then
+    cp "$work/golden.new" "$golden"
+    echo "Updated $golden"
+    exit 0
+fi
+
+echo "$checked runs checked, $failed failed"
+[ "$failed" -eq 0 ]
@@ -0,0 +1,127 @@
+#!/bin/sh
+# Build memsim with -O2, LTO and PGO, measure events per second and peak memory of
+# every policy on a generated trace, write them to perf-results.txt and flag any
+# regression against tests/perf-baseline.txt. The baseline starts with comments
+# naming the machine and compiler it was recorded with and the trace length and
+# frame count it measured, and only compares with runs on that machine with the
+# same settings. Without a baseline the comparison is skipped, as no baseline
+# carries over between machines.
+#
+# Usage: tests/perf.sh               measure and compare against the baseline
+#        tests/perf.sh --baseline    measure and store the results as the baseline
+#
+# CC, PERF_EVENTS (trace length), PERF_FRAMES, PERF_RUNS (best of) and
+# PERF_TOLERANCE (allowed slowdown or memory growth in percent) can be overridden.
+
+CC=${CC:-gcc}
+events=${PERF_EVENTS:-2000000}
+frames=${PERF_FRAMES:-1024}
+runs=${PERF_RUNS:-3}
+tolerance=${PERF_TOLERANCE:-10}
+
+tests=$(dirname "$0")
+root="$tests/.."
+out="$root/perf-build"
+results="$root/perf-results.txt"
+baseline="$tests/perf-baseline.txt"
+settings="events $events frames $frames"
+
+# Results of another trace length or frame count are not comparable.
+if [ "$1" != "--baseline" ] && [ -f "$baseline" ]; then
+    recorded=$(sed -n 's/^# settings: //p' "$baseline")
+    if [ "$recorded" != "$settings" ]; then
+        echo "FAIL: baseline was recorded with ${recorded:-unknown settings}, this run uses $settings"
+        exit 1
+    fi
+fi
+
+mkdir -p "$out"
+
+# A fixed pseudo random trace of two processes, with a hot set, loops and scans.
+trace="$out/perf-$events.trace"
+if [ ! -f "$trace" ]; then
+    awk -v n="$events" 'BEGIN {
+        seed = 12345
+        for (i = 0; i < n; i++) {
+            seed = (seed * 1103515245 + 12345) % 2147483648
+            r = seed % 100
+            if (r < 60) page = seed % 700
+            else if (r < 85) page = 4096 + (i % 3000)
+            else page = seed % 65536
+            hi = (seed % 7 < 3) ? 8 : 0
+            printf "%x%07x %s\n", hi, page * 4096 + seed % 4096, (seed % 10 < 3) ? "W" : "R"
+        }
+    }' > "$trace"
+fi
+
+echo "Building -O2, LTO and PGO variants"
+$CC -O2 -o "$out/memsim-o2" "$root/main.c" || exit 1
+$CC -O2 -flto -o "$out/memsim-lto" "$root/main.c" || exit 1
+
+# PGO trains on the reference traces, so the measured trace stays unseen.
+rm -rf "$out/pgo"
+$CC -O2 -fprofile-generate -fprofile-dir="$out/pgo" -o "$out/memsim-pgo-gen" "$root/main.c" || exit 1
+for policy in rdm lru fifo vms; do
+    for trace_file in "$tests"/traces/*.trace; do
+        "$out/memsim-pgo-gen" "$trace_file" 64 $policy quiet -seed 1 > /dev/null
+    done
+done
+$CC -O2 -fprofile-use -fprofile-correction -Wno-missing-profile -fprofile-dir="$out/pgo" \
+    -o "$out/memsim-pgo" "$root/main.c" || exit 1
+
+# Print "<events per second> <peak KB>", each the best of runs runs.
+measure()
+{
+    i=0
+    while [ $i -lt "$runs" ]; do
+        "$@" -perf | awk '/^Events per second:/ { e = $4 } /^Peak memory:/ { m = $3 } END { print e, m }'
+        i=$((i + 1))
+    done | awk 'NR == 1 || $1 > e { e = $1 } NR == 1 || $2 < m { m = $2 } END { print e, m }'
+}
+
+echo "Measuring $events events with $frames frames, best of $runs"
+: > "$results"
+for variant in o2 lto pgo; do
+    for policy in rdm lru fifo vms; do
+        result=$(measure "$out/memsim-$variant" "$trace" "$frames" $policy quiet -seed 1)
+        echo "$variant $policy $result" >> "$results"
+        printf "%-4s %-5s %12s events/s %8s KB\n" $variant $policy $result
+    done
+done
+
+if [ "$1" = "--baseline" ]; then
+    {
+        echo "# $(uname -sm), $(grep -m 1 'model name' /proc/cpuinfo 2>/dev/null | sed 's/.*: //')," \
+            "$(getconf _NPROCESSORS_ONLN) CPUs, $($CC --version | head -n 1)"
+        echo "# settings: $settings"
+        cat "$results"
+    } > "$baseline"
+    echo "Stored baseline in $baseline"
+    exit 0
+fi
+
+if [ ! -f "$baseline" ]; then
+    echo "SKIPPED: no baseline to compare against, store one on this machine with make perf-baseline"
+    exit 0
+fi
+sed -n '1s/^# /Baseline recorded on /p' "$baseline"
+
+# Join the results with the baseline on variant and policy.
+awk -v tolerance="$tolerance" '
+    /^#/ { next }
+    FNR == NR { eps[$1 " " $2] = $3; mem[$1 " " $2] = $4; next }
+    ($1 " " $2) in eps {
+        key = $1 " " $2
+        if ($3 < eps[key] * (100 - tolerance) / 100) {
+            printf "REGRESSION: %s %.0f events/s, baseline %.0f\n", key, $3, eps[key]
+            failed++
+        }
+        if ($4 > mem[key] * (100 + tolerance) / 100) {
+            printf "REGRESSION: %s %d KB peak memory, baseline %d KB\n", key, $4, mem[key]
+            failed++
+        }
+    }
+    END {
+        if (failed > 0) exit 1
+        print "No regressions against the baseline"
+    }' "$baseline" "$results"